@@ -1,180 +1,1525 @@
-#define _CRT_SECURE_NO_WARNINGS
-#include <stdio.h>
-#include <string.h>
-#include <stdlib.h>
-#include <ctype.h>
-
-#define MAX_DEGREE 100
-
-void remove_spaces(char* str) {
-    char* i = str;
-    char* j = str;
-    while (*j != 0) {
-        *i = *j++;
-        if (*i != ' ') i++;
-    }
-    *i = 0;
-}
-
-void replace_double_star(char* str) {
-    int len = strlen(str);
-    for (int i = 0; i < len - 1; i++) {
-        if (str[i] == '*' && str[i + 1] == '*') {
-            str[i] = '^';
-            for (int j = i + 1; j < len; j++) {
-                str[j] = str[j + 1];
-            }
-            len--;
-        }
-    }
-}
-
-int is_blank_line(const char* str) {
-    for (int i = 0; str[i]; i++) {
-        if (!isspace(str[i])) return 0;
-    }
-    return 1;
-}
-
-void parse_polynomial(const char* line, int* coeff) {
-    memset(coeff, 0, sizeof(int) * (MAX_DEGREE + 1));
-    int sign = 1, i = 0;
-
-    while (line[i]) {
-        int coef = 0, degree = 0, has_coef = 0;
-
-        if (line[i] == '+') {
-            sign = 1;
-            i++;
-        }
-        else if (line[i] == '-') {
-            sign = -1;
-            i++;
-        }
-
-        while (isdigit(line[i])) {
-            coef = coef * 10 + (line[i] - '0');
-            has_coef = 1;
-            i++;
-        }
-
-        if (line[i] == 'x') {
-            i++;
-            if (!has_coef) coef = 1;
-            if (line[i] == '^') {
-                i++;
-                while (isdigit(line[i])) {
-                    degree = degree * 10 + (line[i] - '0');
-                    i++;
-                }
-            }
-            else {
-                degree = 1;
-            }
-        }
-        else {
-            degree = 0;
-        }
-
-        if (degree <= MAX_DEGREE) {
-            coeff[degree] += sign * coef;
-        }
-    }
-}
-
-void print_polynomial(int* coeff) {
-    int first = 1;
-    for (int i = MAX_DEGREE; i >= 0; i--) {
-        if (coeff[i] != 0) {
-            if (!first && coeff[i] > 0) printf(" + ");
-            if (coeff[i] < 0) printf(" - ");
-            if (abs(coeff[i]) != 1 || i == 0)
-                printf("%d", abs(coeff[i]));
-            else if (abs(coeff[i]) == 1 && i == 0)
-                printf("1");
-
-            if (i >= 1) {
-                printf("x");
-                if (i > 1) printf("^%d", i);
-            }
-            first = 0;
-        }
-    }
-    if (first) printf("0");
-    printf("\n");
-}
-
-void add_polynomials(int* a, int* b, int* result) {
-    for (int i = 0; i <= MAX_DEGREE; i++) {
-        result[i] = a[i] + b[i];
-    }
-}
-
-void multiply_polynomials(int* a, int* b, int* result) {
-    memset(result, 0, sizeof(int) * (MAX_DEGREE * 2 + 1));
-    for (int i = 0; i <= MAX_DEGREE; i++) {
-        for (int j = 0; j <= MAX_DEGREE; j++) {
-            if (i + j <= MAX_DEGREE * 2)
-                result[i + j] += a[i] * b[j];
-        }
-    }
-}
-
-int main() {
-    FILE* file = fopen("input.txt", "r");
-    if (!file) {
-        printf("파일을 열 수 없습니다.\n");
-        return 1;
-    }
-
-    char buffer[1024];
-    char line1[1024] = "", line2[1024] = "";
-    int read_count = 0;
-    int pair = 1;
-
-    int poly1[MAX_DEGREE + 1], poly2[MAX_DEGREE + 1];
-    int sum[MAX_DEGREE + 1], product[MAX_DEGREE * 2 + 1];
-
-    while (fgets(buffer, sizeof(buffer), file)) {
-        // 줄 끝 개행 제거
-        buffer[strcspn(buffer, "\r\n")] = 0;
-
-        if (is_blank_line(buffer)) continue;
-
-        if (read_count == 0) {
-            strcpy(line1, buffer);
-            read_count = 1;
-        }
-        else {
-            strcpy(line2, buffer);
-            read_count = 0;
-
-            // 처리 시작
-            printf("\n▶ [%d번째 다항식 쌍]\n", pair++);
-
-            replace_double_star(line1);
-            replace_double_star(line2);
-            remove_spaces(line1);
-            remove_spaces(line2);
-
-            parse_polynomial(line1, poly1);
-            parse_polynomial(line2, poly2);
-
-            printf("정리된 첫 번째 다항식: ");
-            print_polynomial(poly1);
-            printf("정리된 두 번째 다항식: ");
-            print_polynomial(poly2);
-
-            add_polynomials(poly1, poly2, sum);
-            printf("두 다항식의 합: ");
-            print_polynomial(sum);
-
-            multiply_polynomials(poly1, poly2, product);
-            printf("두 다항식의 곱: ");
-            print_polynomial(product);
-        }
-    }
-
-    fclose(file);
-    return 0;
-}
\ No newline at end of file
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_DEGREE 2147483648LL // 2^31, 이보다 차수가 큰 항은 버림
+#define DENSE_RATIO 4           // 차수 범위가 항 수의 이 배 이하이면 밀집 배열로 모음
+
+// 부호와 크기로 나타낸 큰 정수 (계수가 -w로 고른 폭을 넘은 항에만 씀)
+typedef struct {
+    uint32_t* limbs; // 낮은 자리부터, 값이 0이면 length 0
+    int length;
+    int negative;
+} BigInt;
+
+// 계수는 보통 small에 두고 폭을 넘는 값만 big에 둠 (big이 NULL이 아니면 small은 쓰지 않음)
+// 폭 안에 들어오는 값은 언제나 small로 되돌리므로 0은 항상 small
+typedef struct {
+    __int128 small;
+    BigInt* big;
+} Coefficient;
+
+static int coefficient_bits = 64; // -w 64 | -w 128: small이 가질 수 있는 범위
+
+// 희소 다항식: 계수가 0이 아닌 항만 차수 내림차순으로 저장
+typedef struct {
+    long long degree;
+    Coefficient coeff;
+} Term;
+
+typedef struct {
+    Term* terms;
+    int count;
+    int capacity;
+} Polynomial;
+
+// 출력 버퍼 (항마다 printf하지 않고 모아서 한 번에 씀)
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} OutputBuffer;
+
+void init_output(OutputBuffer* out) {
+    out->data = NULL;
+    out->length = 0;
+    out->capacity = 0;
+}
+
+void free_output(OutputBuffer* out) {
+    free(out->data);
+    init_output(out);
+}
+
+// 뒤에 extra바이트를 쓸 자리를 확보
+static char* reserve_output(OutputBuffer* out, size_t extra) {
+    if (out->length + extra > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity : 4096;
+        while (capacity < out->length + extra) capacity *= 2;
+        out->data = realloc(out->data, capacity);
+        out->capacity = capacity;
+    }
+    return out->data + out->length;
+}
+
+void append_text(OutputBuffer* out, const char* text, size_t len) {
+    memcpy(reserve_output(out, len), text, len);
+    out->length += len;
+}
+
+void append_string(OutputBuffer* out, const char* text) {
+    append_text(out, text, strlen(text));
+}
+
+// 버퍼 내용을 파일에 쓰고 비움
+void flush_output(OutputBuffer* out, FILE* fp) {
+    fwrite(out->data, 1, out->length, fp);
+    out->length = 0;
+}
+
+// 자리는 구조체 바로 뒤에 붙여 한 번에 할당 (항마다 큰 정수가 생기는 곱셈에서 할당 횟수를 줄임)
+static BigInt* big_alloc(int length) {
+    size_t limbs = length > 0 ? (size_t)length : 1;
+    BigInt* b = malloc(sizeof(BigInt) + limbs * sizeof(uint32_t));
+    b->limbs = (uint32_t*)(b + 1);
+    memset(b->limbs, 0, limbs * sizeof(uint32_t));
+    b->length = length;
+    b->negative = 0;
+    return b;
+}
+
+static void big_free(BigInt* b) {
+    free(b);
+}
+
+static void big_trim(BigInt* b) {
+    while (b->length > 0 && b->limbs[b->length - 1] == 0) b->length--;
+    if (b->length == 0) b->negative = 0;
+}
+
+static BigInt* big_from_int128(__int128 value) {
+    unsigned __int128 magnitude = value < 0 ? -(unsigned __int128)value : (unsigned __int128)value;
+    BigInt* b = big_alloc(4);
+    for (int i = 0; i < 4; i++) {
+        b->limbs[i] = (uint32_t)magnitude;
+        magnitude >>= 32;
+    }
+    b->negative = value < 0;
+    big_trim(b);
+    return b;
+}
+
+// 10진 숫자열 (부호 없음), 9자리씩 끊어 곱하고 더함
+static BigInt* big_from_decimal(const char* digits, int len) {
+    BigInt* b = big_alloc(len / 9 + 2);
+    b->length = 0;
+    for (int i = 0; i < len; ) {
+        int chunk = len - i < 9 ? len - i : 9;
+        uint32_t value = 0, scale = 1;
+        for (int k = 0; k < chunk; k++) {
+            value = value * 10 + (digits[i + k] - '0');
+            scale *= 10;
+        }
+        i += chunk;
+        uint64_t carry = value;
+        for (int k = 0; k < b->length; k++) {
+            carry += (uint64_t)b->limbs[k] * scale;
+            b->limbs[k] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        if (carry) b->limbs[b->length++] = (uint32_t)carry;
+    }
+    return b;
+}
+
+static int big_compare_abs(const BigInt* a, const BigInt* b) {
+    if (a->length != b->length) return a->length < b->length ? -1 : 1;
+    for (int i = a->length - 1; i >= 0; i--) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static BigInt* big_add(const BigInt* a, const BigInt* b) {
+    // 부호가 다르면 크기가 큰 쪽에서 작은 쪽을 뺌
+    if (a->negative != b->negative && big_compare_abs(a, b) < 0) {
+        const BigInt* t = a;
+        a = b;
+        b = t;
+    }
+    int length = (a->length > b->length ? a->length : b->length) + 1;
+    BigInt* r = big_alloc(length);
+    r->negative = a->negative;
+    if (a->negative == b->negative) {
+        uint64_t carry = 0;
+        for (int i = 0; i < length; i++) {
+            carry += (uint64_t)(i < a->length ? a->limbs[i] : 0) + (i < b->length ? b->limbs[i] : 0);
+            r->limbs[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+    }
+    else {
+        int64_t borrow = 0;
+        for (int i = 0; i < length; i++) {
+            int64_t d = (int64_t)(i < a->length ? a->limbs[i] : 0) - (i < b->length ? b->limbs[i] : 0) - borrow;
+            borrow = d < 0;
+            r->limbs[i] = (uint32_t)(borrow ? d + (1LL << 32) : d);
+        }
+    }
+    big_trim(r);
+    return r;
+}
+
+static BigInt* big_multiply(const BigInt* a, const BigInt* b) {
+    BigInt* r = big_alloc(a->length + b->length);
+    for (int i = 0; i < a->length; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < b->length; j++) {
+            carry += (uint64_t)a->limbs[i] * b->limbs[j] + r->limbs[i + j];
+            r->limbs[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        r->limbs[i + b->length] = (uint32_t)carry;
+    }
+    r->negative = a->negative != b->negative;
+    big_trim(r);
+    return r;
+}
+
+// 크기를 10진수로 붙임 (10^9로 거듭 나눠 9자리씩 얻음)
+static void append_uint128(OutputBuffer* out, unsigned __int128 magnitude) {
+    char text[40];
+    int len = sizeof(text);
+    do {
+        text[--len] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    append_text(out, text + len, sizeof(text) - len);
+}
+
+static void append_big_abs(OutputBuffer* out, const BigInt* b) {
+    int length = b->length;
+    if (length <= 4) { // 128비트에 들어가면 나눗셈 버퍼 없이 바로 씀
+        unsigned __int128 magnitude = 0;
+        for (int i = length - 1; i >= 0; i--) magnitude = magnitude << 32 | b->limbs[i];
+        append_uint128(out, magnitude);
+        return;
+    }
+    uint32_t* work = malloc((length + 1) * sizeof(uint32_t));
+    uint32_t* chunks = malloc((2 * length + 1) * sizeof(uint32_t));
+    memcpy(work, b->limbs, length * sizeof(uint32_t));
+    int count = 0;
+    while (length > 0) {
+        uint64_t remainder = 0;
+        for (int i = length - 1; i >= 0; i--) {
+            uint64_t current = (remainder << 32) | work[i];
+            work[i] = (uint32_t)(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        chunks[count++] = (uint32_t)remainder;
+        while (length > 0 && work[length - 1] == 0) length--;
+    }
+    if (count == 0) append_string(out, "0");
+    else {
+        char* dest = reserve_output(out, 9 * (size_t)count + 1);
+        int len = snprintf(dest, 10, "%u", chunks[count - 1]);
+        for (int i = count - 2; i >= 0; i--) len += snprintf(dest + len, 10, "%09u", chunks[i]);
+        out->length += len;
+    }
+    free(work);
+    free(chunks);
+}
+
+static __int128 small_max(void) {
+    return coefficient_bits == 64 ? INT64_MAX : (__int128)(((unsigned __int128)1 << 127) - 1);
+}
+
+// b가 폭 안에 들어가면 small로 옮기고 b를 해제
+static void set_big(Coefficient* c, BigInt* b) {
+    c->big = b;
+    if (b->length > 4) return;
+    unsigned __int128 magnitude = 0;
+    for (int i = b->length - 1; i >= 0; i--) magnitude = magnitude << 32 | b->limbs[i];
+    unsigned __int128 limit = (unsigned __int128)small_max() + b->negative; // 음수 쪽이 하나 더 넓음
+    if (magnitude > limit) return;
+    c->small = (__int128)(b->negative ? 0 - magnitude : magnitude);
+    c->big = NULL;
+    big_free(b);
+}
+
+static BigInt* to_big(const Coefficient* c) {
+    if (!c->big) return big_from_int128(c->small);
+    BigInt* b = big_alloc(c->big->length);
+    memcpy(b->limbs, c->big->limbs, c->big->length * sizeof(uint32_t));
+    b->negative = c->big->negative;
+    return b;
+}
+
+static void coefficient_free(Coefficient* c) {
+    big_free(c->big);
+    c->big = NULL;
+}
+
+static Coefficient coefficient_copy(const Coefficient* c) {
+    Coefficient r = { c->small, c->big ? to_big(c) : NULL };
+    return r;
+}
+
+static int coefficient_sign(const Coefficient* c) {
+    if (c->big) return c->big->negative ? -1 : 1;
+    return c->small < 0 ? -1 : c->small > 0;
+}
+
+// 숫자열을 계수로 읽음 (폭을 넘으면 큰 정수로 다시 읽음)
+static Coefficient parse_coefficient(const char* digits, int len) {
+    Coefficient c = { 0, NULL };
+    __int128 limit = small_max();
+    for (int k = 0; k < len; k++) {
+        int digit = digits[k] - '0';
+        if (c.small > (limit - digit) / 10) {
+            set_big(&c, big_from_decimal(digits, len));
+            return c;
+        }
+        c.small = c.small * 10 + digit;
+    }
+    return c;
+}
+
+static void coefficient_negate(Coefficient* c) {
+    if (!c->big) {
+        c->small = -c->small; // 읽은 값은 양수라 넘치지 않음
+        return;
+    }
+    BigInt* b = c->big;
+    b->negative = !b->negative && b->length > 0;
+    set_big(c, b);
+}
+
+// 계수가 __int128에 들어가면 value에 두고 1 (64비트 폭에서 큰 정수로 둔 값도 128비트로 계산하려고 씀)
+static int coefficient_int128(const Coefficient* c, __int128* value) {
+    if (!c->big) {
+        *value = c->small;
+        return 1;
+    }
+    if (c->big->length > 4 || (c->big->length == 4 && c->big->limbs[3] >> 31)) return 0;
+    unsigned __int128 magnitude = 0;
+    for (int i = c->big->length - 1; i >= 0; i--) magnitude = magnitude << 32 | c->big->limbs[i];
+    *value = c->big->negative ? -(__int128)magnitude : (__int128)magnitude;
+    return 1;
+}
+
+// acc += x: 둘 다 small이면 bits 폭으로 넘침을 검사하며 더하고, 넘칠 때만 큰 정수로 계산
+// (bits가 128이면 128비트에 들어가는 큰 정수도 small처럼 더하고 결과 small이 폭을 넘을 수 있으므로
+// 나중에 coefficient_fit으로 맞춤)
+static void coefficient_add_bits(Coefficient* acc, const Coefficient* x, int bits) {
+    __int128 u, v;
+    if (bits == 128 && coefficient_int128(acc, &u) && coefficient_int128(x, &v)) {
+        __int128 r;
+        if (!__builtin_add_overflow(u, v, &r)) {
+            coefficient_free(acc);
+            acc->small = r;
+            return;
+        }
+    }
+    else if (bits == 64 && !acc->big && !x->big) {
+        long long r;
+        if (!__builtin_add_overflow((long long)acc->small, (long long)x->small, &r)) {
+            acc->small = r;
+            return;
+        }
+    }
+    BigInt* a = to_big(acc);
+    BigInt* b = to_big(x);
+    coefficient_free(acc);
+    set_big(acc, big_add(a, b));
+    big_free(a);
+    big_free(b);
+}
+
+static void coefficient_add(Coefficient* acc, const Coefficient* x) {
+    coefficient_add_bits(acc, x, coefficient_bits);
+}
+
+// 폭과 상관없이 128비트로 넘침을 검사하며 곱함 (64비트 폭이면 결과 small이 폭을 넘을 수 있음)
+static Coefficient coefficient_multiply(const Coefficient* a, const Coefficient* b) {
+    Coefficient r = { 0, NULL };
+    __int128 u, v;
+    if (coefficient_int128(a, &u) && coefficient_int128(b, &v) && !__builtin_mul_overflow(u, v, &r.small)) return r;
+    BigInt* x = to_big(a);
+    BigInt* y = to_big(b);
+    set_big(&r, big_multiply(x, y));
+    big_free(x);
+    big_free(y);
+    return r;
+}
+
+// 고른 폭을 넘는 small을 큰 정수로 옮김
+static void coefficient_fit(Coefficient* c) {
+    if (!c->big && coefficient_bits == 64 && (c->small < INT64_MIN || c->small > INT64_MAX)) {
+        set_big(c, big_from_int128(c->small));
+    }
+}
+
+void init_polynomial(Polynomial* p) {
+    p->terms = NULL;
+    p->count = 0;
+    p->capacity = 0;
+}
+
+// 항을 모두 지움 (큰 정수 계수도 해제)
+static void clear_polynomial(Polynomial* p) {
+    for (int i = 0; i < p->count; i++) coefficient_free(&p->terms[i].coeff);
+    p->count = 0;
+}
+
+void free_polynomial(Polynomial* p) {
+    clear_polynomial(p);
+    free(p->terms);
+    init_polynomial(p);
+}
+
+static void reserve_terms(Polynomial* p, long long n) {
+    if (n > INT_MAX) {
+        fprintf(stderr, "항이 너무 많습니다 (%lld개)\n", n);
+        exit(1);
+    }
+    if (n > p->capacity) {
+        long long capacity = n > 2LL * p->capacity ? n : 2LL * p->capacity;
+        if (capacity > INT_MAX) capacity = INT_MAX;
+        Term* terms = realloc(p->terms, capacity * sizeof(Term));
+        if (!terms) {
+            fprintf(stderr, "메모리가 부족합니다 (항 %lld개)\n", capacity);
+            exit(1);
+        }
+        p->terms = terms;
+        p->capacity = (int)capacity;
+    }
+}
+
+// coeff의 큰 정수는 다항식이 가져감
+static void append_term(Polynomial* p, long long degree, Coefficient coeff) {
+    reserve_terms(p, p->count + 1LL);
+    p->terms[p->count].degree = degree;
+    p->terms[p->count].coeff = coeff;
+    p->count++;
+}
+
+static int compare_terms(const void* a, const void* b) {
+    long long x = ((const Term*)a)->degree, y = ((const Term*)b)->degree;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// 순서 없이 모은 항을 차수 내림차순으로 정리 (같은 차수는 합치고 0인 항은 뺌)
+// 차수 범위가 항 수에 비해 좁으면 밀집 배열에 더해 정렬 없이 끝냄
+static void normalize_polynomial(Polynomial* p) {
+    if (p->count == 0) return;
+    long long low = p->terms[0].degree, high = low;
+    for (int i = 1; i < p->count; i++) {
+        if (p->terms[i].degree < low) low = p->terms[i].degree;
+        if (p->terms[i].degree > high) high = p->terms[i].degree;
+    }
+
+    int count = 0;
+    if (high - low < (long long)DENSE_RATIO * p->count) {
+        Coefficient* dense = calloc(high - low + 1, sizeof(Coefficient));
+        for (int i = 0; i < p->count; i++) {
+            Coefficient* slot = &dense[p->terms[i].degree - low];
+            if (!slot->big && slot->small == 0) {
+                *slot = p->terms[i].coeff; // 빈 칸이면 옮기기만 함 (큰 정수를 복사하지 않음)
+                continue;
+            }
+            coefficient_add_bits(slot, &p->terms[i].coeff, 128);
+            coefficient_free(&p->terms[i].coeff);
+        }
+        for (long long d = high; d >= low; d--) {
+            coefficient_fit(&dense[d - low]);
+            if (coefficient_sign(&dense[d - low]) != 0) {
+                p->terms[count].degree = d;
+                p->terms[count].coeff = dense[d - low];
+                count++;
+            }
+        }
+        free(dense);
+    }
+    else {
+        qsort(p->terms, p->count, sizeof(Term), compare_terms);
+        for (int i = 0; i < p->count; ) {
+            Term sum = p->terms[i++];
+            for (; i < p->count && p->terms[i].degree == sum.degree; i++) {
+                coefficient_add_bits(&sum.coeff, &p->terms[i].coeff, 128);
+                coefficient_free(&p->terms[i].coeff);
+            }
+            coefficient_fit(&sum.coeff);
+            if (coefficient_sign(&sum.coeff) != 0) p->terms[count++] = sum;
+        }
+    }
+    p->count = count;
+}
+
+// 줄 끝의 개행을 뺀 길이 (줄 안에 \r이나 NUL이 있으면 거기까지)
+static size_t text_length(const char* line, size_t len) {
+    size_t i = 0;
+    while (i < len && line[i] != '\r' && line[i] != '\n' && line[i] != '\0') i++;
+    return i;
+}
+
+int is_blank_line(const char* line, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!isspace((unsigned char)line[i])) return 0;
+    }
+    return 1;
+}
+
+// 파싱 오류 위치 (줄 안의 바이트 위치, 0부터)와 이유
+typedef struct {
+    size_t position;
+    const char* message;
+} ParseError;
+
+static size_t skip_spaces(const char* line, size_t i, size_t len) {
+    while (i < len && isspace((unsigned char)line[i])) i++;
+    return i;
+}
+
+static int parse_fail(ParseError* error, const char* line, size_t len, size_t i, const char* expected) {
+    static const char known[] = "+-*^x0123456789";
+    error->position = i;
+    error->message = i < len && !memchr(known, line[i], sizeof(known) - 1) ? "알 수 없는 문자" : expected;
+    return 0;
+}
+
+// 줄을 복사하거나 고치지 않고 한 번 훑으며 항을 읽음
+// 문법: [부호] 항 (부호 항)*, 항 = 계수 [*] x [^ 지수] | x [^ 지수] | 계수 (^ 대신 ** 가능)
+// 공백은 기호 사이 어디에나 올 수 있고 같은 차수의 항은 합침, 차수가 MAX_DEGREE를 넘는 항은 버림
+// 반환값: 문법에 맞지 않으면 0 (error에 위치와 이유)
+int parse_polynomial(const char* line, size_t len, Polynomial* poly, ParseError* error) {
+    clear_polynomial(poly);
+    size_t i = skip_spaces(line, 0, len);
+    int sign = 1;
+    if (i < len && (line[i] == '+' || line[i] == '-')) {
+        sign = line[i] == '-' ? -1 : 1;
+        i = skip_spaces(line, i + 1, len);
+    }
+
+    for (;;) {
+        size_t digits = i;
+        while (i < len && isdigit((unsigned char)line[i])) i++;
+        int has_coef = i > digits;
+        Coefficient coef = { 1, NULL };
+        if (has_coef) coef = parse_coefficient(line + digits, (int)(i - digits));
+        i = skip_spaces(line, i, len);
+
+        // 3*x (** 는 지수 표기라 여기서는 보지 않음)
+        if (has_coef && i < len && line[i] == '*' && !(i + 1 < len && line[i + 1] == '*')) {
+            i = skip_spaces(line, i + 1, len);
+            if (i >= len || line[i] != 'x') {
+                coefficient_free(&coef);
+                return parse_fail(error, line, len, i, "x가 필요합니다");
+            }
+        }
+
+        long long degree = 0;
+        if (i < len && line[i] == 'x') {
+            i = skip_spaces(line, i + 1, len);
+            degree = 1;
+            size_t exponent = 0;
+            if (i < len && line[i] == '^') exponent = 1;
+            else if (i + 1 < len && line[i] == '*' && line[i + 1] == '*') exponent = 2;
+            if (exponent) {
+                i = skip_spaces(line, i + exponent, len);
+                if (i >= len || !isdigit((unsigned char)line[i])) {
+                    coefficient_free(&coef);
+                    return parse_fail(error, line, len, i, "지수가 필요합니다");
+                }
+                degree = 0;
+                while (i < len && isdigit((unsigned char)line[i])) {
+                    // MAX_DEGREE를 넘으면 더 자라지 않게 멈춤 (어차피 버릴 항)
+                    if (degree <= MAX_DEGREE) degree = degree * 10 + (line[i] - '0');
+                    i++;
+                }
+                i = skip_spaces(line, i, len);
+            }
+        }
+        else if (!has_coef) {
+            return parse_fail(error, line, len, i, "항이 필요합니다");
+        }
+
+        if (degree <= MAX_DEGREE) {
+            if (sign < 0) coefficient_negate(&coef);
+            append_term(poly, degree, coef);
+        }
+        else {
+            coefficient_free(&coef);
+        }
+
+        if (i >= len) break;
+        if (line[i] != '+' && line[i] != '-') return parse_fail(error, line, len, i, "+ 또는 -가 필요합니다");
+        sign = line[i] == '-' ? -1 : 1;
+        i = skip_spaces(line, i + 1, len);
+    }
+    normalize_polynomial(poly);
+    return 1;
+}
+
+// "입력 오류 - 5번째 글자 '@': 알 수 없는 문자"
+static void append_parse_error(OutputBuffer* out, const char* line, size_t len, const ParseError* error) {
+    char* dest = reserve_output(out, 160);
+    if (error->position >= len) {
+        out->length += snprintf(dest, 160, "입력 오류 - 줄 끝: %s\n", error->message);
+    }
+    else if (isprint((unsigned char)line[error->position])) {
+        out->length += snprintf(dest, 160, "입력 오류 - %zu번째 글자 '%c': %s\n", error->position + 1,
+                                line[error->position], error->message);
+    }
+    else {
+        out->length += snprintf(dest, 160, "입력 오류 - %zu번째 글자: %s\n", error->position + 1, error->message);
+    }
+}
+
+static int is_unit(const Coefficient* c) {
+    return !c->big && (c->small == 1 || c->small == -1);
+}
+
+static void append_coefficient_abs(OutputBuffer* out, const Coefficient* c) {
+    if (c->big) {
+        append_big_abs(out, c->big);
+        return;
+    }
+    append_uint128(out, c->small < 0 ? -(unsigned __int128)c->small : (unsigned __int128)c->small);
+}
+
+void append_polynomial(OutputBuffer* out, const Polynomial* poly) {
+    int first = 1;
+    for (int k = 0; k < poly->count; k++) {
+        long long i = poly->terms[k].degree;
+        const Coefficient* coeff = &poly->terms[k].coeff;
+        int sign = coefficient_sign(coeff);
+        if (!first && sign > 0) append_string(out, " + ");
+        if (sign < 0) append_string(out, " - ");
+        if (!is_unit(coeff) || i == 0)
+            append_coefficient_abs(out, coeff);
+        else if (is_unit(coeff) && i == 0)
+            append_string(out, "1");
+
+        if (i >= 1) {
+            append_string(out, "x");
+            if (i > 1) {
+                char* dest = reserve_output(out, 24);
+                out->length += snprintf(dest, 24, "^%lld", i);
+            }
+        }
+        first = 0;
+    }
+    if (first) append_string(out, "0");
+    append_string(out, "\n");
+}
+
+// 두 항 목록을 차수 순서대로 한 번 훑으며 합침 (항 수에 비례)
+void add_polynomials(const Polynomial* a, const Polynomial* b, Polynomial* result) {
+    clear_polynomial(result);
+    reserve_terms(result, (long long)a->count + b->count);
+    int i = 0, j = 0;
+    while (i < a->count || j < b->count) {
+        if (j == b->count || (i < a->count && a->terms[i].degree > b->terms[j].degree)) {
+            append_term(result, a->terms[i].degree, coefficient_copy(&a->terms[i].coeff));
+            i++;
+        }
+        else if (i == a->count || b->terms[j].degree > a->terms[i].degree) {
+            append_term(result, b->terms[j].degree, coefficient_copy(&b->terms[j].coeff));
+            j++;
+        }
+        else {
+            Coefficient sum = coefficient_copy(&a->terms[i].coeff);
+            coefficient_add(&sum, &b->terms[j].coeff);
+            if (coefficient_sign(&sum) != 0) append_term(result, a->terms[i].degree, sum);
+            i++;
+            j++;
+        }
+    }
+}
+
+// 밀집 곱셈 커널: 계수 배열은 낮은 차수부터, 값은 2^64를 법으로 계산함
+// (int로 자르면 항별로 곱해 더한 결과와 같으므로 커널을 바꿔도 출력이 같음)
+// 두 임계값의 기본값은 고정값이고, 실행할 기계에서 -b가 고른 값을 -k, -n으로 넘겨 바꿈
+#define KARATSUBA_THRESHOLD 32     // 짧은 쪽 길이가 이보다 짧으면 교과서 방식
+#define NTT_THRESHOLD 65535        // 결과 길이가 이 이상이면 NTT
+#define NTT_MAX_LENGTH (1 << 23)   // 세 소수 모두 이 길이까지 변환 가능
+
+static int karatsuba_threshold = KARATSUBA_THRESHOLD; // -k (벤치마크 중에는 잠시 바꿈)
+static int ntt_threshold = NTT_THRESHOLD;             // -n
+
+// out[0..n+m-2] = a * b
+static void multiply_schoolbook(const unsigned long long* a, int n, const unsigned long long* b, int m,
+                                unsigned long long* out) {
+    memset(out, 0, (n + m - 1) * sizeof(unsigned long long));
+    for (int i = 0; i < n; i++) {
+        if (a[i] == 0) continue;
+        for (int j = 0; j < m; j++) out[i + j] += a[i] * b[j];
+    }
+}
+
+// 길이가 같은 두 배열의 곱 out[0..2n-2], scratch는 4n + 128칸 이상
+static void karatsuba(const unsigned long long* a, const unsigned long long* b, int n, unsigned long long* out,
+                      unsigned long long* scratch) {
+    if (n < karatsuba_threshold || n < 2) {
+        multiply_schoolbook(a, n, b, n, out);
+        return;
+    }
+    int lo = n / 2, hi = n - lo;
+    unsigned long long* sum_a = scratch;
+    unsigned long long* sum_b = sum_a + hi;
+    unsigned long long* middle = sum_b + hi;
+    unsigned long long* rest = middle + 2 * hi;
+    for (int i = 0; i < hi; i++) {
+        sum_a[i] = a[lo + i] + (i < lo ? a[i] : 0);
+        sum_b[i] = b[lo + i] + (i < lo ? b[i] : 0);
+    }
+
+    // (a0 + a1)(b0 + b1) - a0 b0 - a1 b1을 가운데에 더함
+    karatsuba(a, b, lo, out, rest);
+    out[2 * lo - 1] = 0;
+    karatsuba(a + lo, b + lo, hi, out + 2 * lo, rest);
+    karatsuba(sum_a, sum_b, hi, middle, rest);
+    for (int i = 0; i < 2 * lo - 1; i++) middle[i] -= out[i];
+    for (int i = 0; i < 2 * hi - 1; i++) middle[i] -= out[2 * lo + i];
+    for (int i = 0; i < 2 * hi - 1; i++) out[lo + i] += middle[i];
+}
+
+// 길이가 다르면 긴 쪽을 짧은 쪽 길이로 잘라 블록마다 곱해 더함 (n >= m)
+static void multiply_karatsuba(const unsigned long long* a, int n, const unsigned long long* b, int m,
+                               unsigned long long* out) {
+    unsigned long long* block = calloc(m, sizeof(unsigned long long));
+    unsigned long long* product = malloc((2 * m - 1) * sizeof(unsigned long long));
+    unsigned long long* scratch = malloc((4 * (size_t)m + 128) * sizeof(unsigned long long));
+    memset(out, 0, (n + m - 1) * sizeof(unsigned long long));
+    for (int k = 0; k < n; k += m) {
+        int len = n - k < m ? n - k : m;
+        const unsigned long long* part = a + k;
+        if (len < m) {
+            memcpy(block, part, len * sizeof(unsigned long long));
+            part = block;
+        }
+        karatsuba(part, b, m, product, scratch);
+        int limit = len + m - 1;
+        for (int i = 0; i < limit; i++) out[k + i] += product[i];
+    }
+    free(block);
+    free(product);
+    free(scratch);
+}
+
+// NTT용 소수 (모두 원시근 3, 2^23 길이까지 변환 가능)와 CRT로 복원하는 정확한 정수 곱
+// 세 소수의 곱 M은 약 2^86이라 |계수| < M/2인 동안 결과가 정확함 (int 계수면 길이 2^23까지 성립)
+static const unsigned ntt_primes[3] = { 998244353u, 167772161u, 469762049u };
+
+static unsigned power_mod(unsigned long long base, unsigned long long exponent, unsigned mod) {
+    unsigned long long result = 1;
+    base %= mod;
+    while (exponent) {
+        if (exponent & 1) result = result * base % mod;
+        base = base * base % mod;
+        exponent >>= 1;
+    }
+    return (unsigned)result;
+}
+
+static inline void ntt(unsigned* a, int n, int invert, unsigned mod) {
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            unsigned t = a[i];
+            a[i] = a[j];
+            a[j] = t;
+        }
+    }
+    // 단계별 원시근은 전체 길이의 원시근을 거듭 제곱해 얻음 (roots[k]는 길이 2^(k+1)용)
+    unsigned long long roots[32];
+    int levels = 0;
+    while ((1 << levels) < n) levels++;
+    unsigned long long top = power_mod(3, (mod - 1) / n, mod);
+    if (invert) top = power_mod(top, mod - 2, mod);
+    for (int k = levels - 1; k >= 0; k--) {
+        roots[k] = top;
+        top = top * top % mod;
+    }
+    for (int len = 2, k = 0; len <= n; len <<= 1, k++) {
+        unsigned long long root = roots[k];
+        int half = len >> 1;
+        for (int i = 0; i < n; i += len) {
+            unsigned long long w = 1;
+            for (int j = 0; j < half; j++) {
+                unsigned u = a[i + j];
+                unsigned v = (unsigned)(a[i + j + half] * w % mod);
+                a[i + j] = u + v < mod ? u + v : u + v - mod;
+                a[i + j + half] = u >= v ? u - v : u + mod - v;
+                w = w * root % mod;
+            }
+        }
+    }
+    if (invert) {
+        unsigned long long inverse = power_mod(n, mod - 2, mod);
+        for (int i = 0; i < n; i++) a[i] = (unsigned)(a[i] * inverse % mod);
+    }
+}
+
+// fa = fa * fb (순환 합성곱)
+static inline void ntt_convolve(unsigned* fa, unsigned* fb, int size, unsigned mod) {
+    ntt(fa, size, 0, mod);
+    ntt(fb, size, 0, mod);
+    for (int i = 0; i < size; i++) fa[i] = (unsigned)((unsigned long long)fa[i] * fb[i] % mod);
+    ntt(fa, size, 1, mod);
+}
+
+static unsigned reduce_signed(unsigned long long value, unsigned mod) {
+    long long r = (long long)value % (long long)mod;
+    return (unsigned)(r < 0 ? r + mod : r);
+}
+
+static void multiply_ntt(const unsigned long long* a, int n, const unsigned long long* b, int m,
+                         unsigned long long* out) {
+    int length = n + m - 1, size = 1;
+    while (size < length) size <<= 1;
+    unsigned* residues[3];
+    unsigned* fb = malloc(size * sizeof(unsigned));
+    for (int p = 0; p < 3; p++) {
+        unsigned mod = ntt_primes[p];
+        unsigned* fa = calloc(size, sizeof(unsigned));
+        memset(fb, 0, size * sizeof(unsigned));
+        for (int i = 0; i < n; i++) fa[i] = reduce_signed(a[i], mod);
+        for (int i = 0; i < m; i++) fb[i] = reduce_signed(b[i], mod);
+        // 법이 상수로 보이도록 소수마다 따로 펼쳐 나눗셈을 곱셈으로 바꾸게 함
+        if (p == 0) ntt_convolve(fa, fb, size, 998244353u);
+        else if (p == 1) ntt_convolve(fa, fb, size, 167772161u);
+        else ntt_convolve(fa, fb, size, 469762049u);
+        residues[p] = fa;
+    }
+    free(fb);
+
+    // Garner: x = r0 + p0 k1 + p0 p1 k2 (0 <= x < M), M/2 이상이면 음수
+    unsigned p0 = ntt_primes[0], p1 = ntt_primes[1], p2 = ntt_primes[2];
+    unsigned long long inv_p0_mod_p1 = power_mod(p0, p1 - 2, p1);
+    unsigned long long inv_p0p1_mod_p2 = power_mod((unsigned long long)p0 * p1 % p2, p2 - 2, p2);
+    unsigned __int128 modulus = (unsigned __int128)p0 * p1 * p2;
+    for (int i = 0; i < length; i++) {
+        unsigned long long r0 = residues[0][i], r1 = residues[1][i], r2 = residues[2][i];
+        unsigned long long k1 = (r1 + p1 - r0 % p1) % p1 * inv_p0_mod_p1 % p1;
+        unsigned long long partial = (r0 + p0 % p2 * k1) % p2;
+        unsigned long long k2 = (r2 + p2 - partial) % p2 * inv_p0p1_mod_p2 % p2;
+        unsigned __int128 x = r0 + (unsigned __int128)p0 * k1 + (unsigned __int128)p0 * p1 * k2;
+        if (x >= modulus / 2) x -= modulus; // 2^128을 법으로 빼도 하위 64비트는 x - M과 같음
+        out[i] = (unsigned long long)x;
+    }
+    for (int p = 0; p < 3; p++) free(residues[p]);
+}
+
+// 길이에 따라 커널을 고름
+static void multiply_dense(const unsigned long long* a, int n, const unsigned long long* b, int m,
+                           unsigned long long* out) {
+    if (n < m) {
+        const unsigned long long* t = a;
+        a = b;
+        b = t;
+        int k = n;
+        n = m;
+        m = k;
+    }
+    if (m < karatsuba_threshold) multiply_schoolbook(a, n, b, m, out);
+    else if (n + m - 1 >= ntt_threshold && n + m - 1 <= NTT_MAX_LENGTH) multiply_ntt(a, n, b, m, out);
+    else multiply_karatsuba(a, n, b, m, out);
+}
+
+#define SPARSE_WEIGHT 16 // 곱 하나를 해시에 더하는 비용 (밀집 커널의 곱셈-덧셈 횟수로 환산한 대략값)
+#define BIG_WEIGHT 384   // 곱이나 합이 128비트를 넘어 큰 정수로 더할 때의 비용
+#define NTT_WEIGHT 48    // NTT 나비 연산 하나의 비용 (NTT 임계값 근처에서 카라추바와 비슷해지게 맞춘 값)
+
+static double karatsuba_cost(double m) {
+    if (m < karatsuba_threshold || m < 2) return m * m;
+    double hi = m - (double)(long long)(m / 2);
+    return 3 * karatsuba_cost(hi) + 4 * m;
+}
+
+// 길이 n, m인 배열을 multiply_dense로 곱할 때의 대략적인 곱셈-덧셈 횟수 (같은 기준으로 커널을 고름)
+static double dense_cost(double n, double m) {
+    if (n < m) {
+        double t = n;
+        n = m;
+        m = t;
+    }
+    double length = n + m - 1;
+    if (m < karatsuba_threshold) return n * m;
+    if (length >= ntt_threshold && length <= NTT_MAX_LENGTH) {
+        double size = 1, levels = 0;
+        while (size < length) {
+            size *= 2;
+            levels++;
+        }
+        return NTT_WEIGHT * size * levels;
+    }
+    double blocks = (double)(long long)((n + m - 1) / m);
+    return blocks * karatsuba_cost(m);
+}
+
+// 배열로 펼쳐 밀집 커널로 곱하는 편이 항의 쌍을 해시에 더하는 것보다 싼지
+// (각 다항식의 밀도가 아니라 펼친 길이로 드는 비용과 count_a·count_b를 비교함)
+// stride는 계수 하나를 펼치는 칸 수 (multiply_wide의 자리 수, 아니면 1), weight는 곱 하나를 더하는 비용
+static int prefer_dense(const Polynomial* a, const Polynomial* b, int stride, int weight) {
+    double n = (double)(a->terms[0].degree - a->terms[a->count - 1].degree + 1) * stride;
+    double m = (double)(b->terms[0].degree - b->terms[b->count - 1].degree + 1) * stride;
+    if (n + m - 1 > INT_MAX) return 0;
+    return dense_cost(n, m) + 2 * (n + m) <= (double)weight * a->count * b->count;
+}
+
+// 밀집 커널은 64비트로 계산하므로 모든 결과 계수가 int64에 들어간다고 보장될 때만 씀
+// 한 결과 항은 최대 min(항 수)개의 곱의 합이므로 |계수 최댓값| 곱에 그 수를 곱해 봄
+static int product_fits_int64(const Polynomial* a, const Polynomial* b) {
+    unsigned __int128 max_a = 0, max_b = 0;
+    for (int k = 0; k < 2; k++) {
+        const Polynomial* p = k ? b : a;
+        unsigned __int128 largest = 0;
+        for (int i = 0; i < p->count; i++) {
+            const Coefficient* c = &p->terms[i].coeff;
+            if (c->big) return 0;
+            unsigned __int128 magnitude = c->small < 0 ? -(unsigned __int128)c->small : (unsigned __int128)c->small;
+            if (magnitude > largest) largest = magnitude;
+        }
+        if (largest > INT64_MAX) return 0;
+        if (k) max_b = largest;
+        else max_a = largest;
+    }
+    unsigned __int128 product = max_a * max_b;
+    if (product > INT64_MAX) return 0;
+    return product * (a->count < b->count ? a->count : b->count) <= INT64_MAX;
+}
+
+// 희소 항 목록을 낮은 차수부터의 밀집 배열로 펼침
+static unsigned long long* expand_polynomial(const Polynomial* p, int* length) {
+    long long low = p->terms[p->count - 1].degree;
+    *length = (int)(p->terms[0].degree - low + 1);
+    unsigned long long* dense = calloc(*length, sizeof(unsigned long long));
+    for (int i = 0; i < p->count; i++) {
+        dense[p->terms[i].degree - low] = (unsigned long long)(long long)p->terms[i].coeff.small;
+    }
+    return dense;
+}
+
+// 폭이 넓은 계수: 계수를 LIMB_BITS비트 자리로 나눠 자리마다 부호를 붙이고, 차수 d의 i번째 자리를
+// d·S + i 칸에 둔 배열 (S = 두 다항식의 자리 수 합 - 1)끼리 밀집 커널로 곱함
+// 자리끼리의 곱은 2^32 미만이고 한 칸에 더해지는 곱은 min(자리 수)·min(항 수)개 이하라
+// 그 수가 2^31 미만이면 2^64를 법으로 한 커널 결과가 정확함
+// 결과 차수 r의 계수는 r·S부터 S칸을 2^LIMB_BITS진법으로 모은 값 (128비트를 넘는 항만 큰 정수로 계산)
+#define LIMB_BITS 16
+
+static int coefficient_bit_length(const Coefficient* c) {
+    if (c->big) return 32 * (c->big->length - 1) + 32 - __builtin_clz(c->big->limbs[c->big->length - 1]);
+    unsigned __int128 magnitude = c->small < 0 ? -(unsigned __int128)c->small : (unsigned __int128)c->small;
+    unsigned long long high = (unsigned long long)(magnitude >> 64), low = (unsigned long long)magnitude;
+    if (high) return 128 - __builtin_clzll(high);
+    return low ? 64 - __builtin_clzll(low) : 0;
+}
+
+static int max_bit_length(const Polynomial* p) {
+    int bits = 1;
+    for (int i = 0; i < p->count; i++) {
+        int b = coefficient_bit_length(&p->terms[i].coeff);
+        if (b > bits) bits = b;
+    }
+    return bits;
+}
+
+static unsigned long long* expand_limbs(const Polynomial* p, int limbs, int stride, int* length) {
+    long long low = p->terms[p->count - 1].degree;
+    *length = (int)((p->terms[0].degree - low + 1) * stride);
+    unsigned long long* dense = calloc(*length, sizeof(unsigned long long));
+    for (int k = 0; k < p->count; k++) {
+        const Coefficient* c = &p->terms[k].coeff;
+        unsigned long long* slot = dense + (p->terms[k].degree - low) * stride;
+        int negative = coefficient_sign(c) < 0;
+        unsigned __int128 magnitude = c->small < 0 ? -(unsigned __int128)c->small : (unsigned __int128)c->small;
+        for (int i = 0; i < limbs; i++) {
+            unsigned digit;
+            if (c->big) {
+                int word = i * LIMB_BITS / 32;
+                digit = word < c->big->length ? (c->big->limbs[word] >> (i * LIMB_BITS % 32)) & 0xFFFF : 0;
+            }
+            else {
+                digit = i * LIMB_BITS < 128 ? (unsigned)(magnitude >> (i * LIMB_BITS)) & 0xFFFF : 0;
+            }
+            slot[i] = negative ? 0 - (unsigned long long)digit : digit;
+        }
+    }
+    return dense;
+}
+
+// 폭 안에 들어가면 small, 아니면 큰 정수
+static Coefficient coefficient_from_int128(__int128 value) {
+    Coefficient c = { value, NULL };
+    coefficient_fit(&c);
+    return c;
+}
+
+// digits[0..stride-1]을 2^LIMB_BITS진법으로 모음
+static Coefficient combine_limbs(const unsigned long long* digits, int stride) {
+    __int128 value = 0;
+    int k = stride - 1;
+    for (; k >= 0; k--) {
+        __int128 shifted, next;
+        if (__builtin_mul_overflow(value, (__int128)1 << LIMB_BITS, &shifted)) break;
+        if (__builtin_add_overflow(shifted, (__int128)(long long)digits[k], &next)) break;
+        value = next;
+    }
+    if (k < 0) return coefficient_from_int128(value);
+
+    BigInt* acc = big_from_int128(value);
+    BigInt* base = big_from_int128((__int128)1 << LIMB_BITS);
+    for (; k >= 0; k--) {
+        BigInt* shifted = big_multiply(acc, base);
+        BigInt* digit = big_from_int128((long long)digits[k]);
+        big_free(acc);
+        acc = big_add(shifted, digit);
+        big_free(shifted);
+        big_free(digit);
+    }
+    big_free(base);
+    Coefficient c = { 0, NULL };
+    set_big(&c, acc);
+    return c;
+}
+
+// 반환값: 자리 곱의 합이 64비트에 들어간다고 보장할 수 없으면 0 (결과는 건드리지 않음)
+static int multiply_wide(const Polynomial* a, int limbs_a, const Polynomial* b, int limbs_b, Polynomial* result) {
+    double terms = (double)(limbs_a < limbs_b ? limbs_a : limbs_b) * (a->count < b->count ? a->count : b->count);
+    if (terms >= 2147483648.0) return 0;
+    int stride = limbs_a + limbs_b - 1, n, m;
+    unsigned long long* da = expand_limbs(a, limbs_a, stride, &n);
+    unsigned long long* db = expand_limbs(b, limbs_b, stride, &m);
+    unsigned long long* product = malloc((n + m - 1) * sizeof(unsigned long long));
+    multiply_dense(da, n, db, m, product);
+    long long low = a->terms[a->count - 1].degree + b->terms[b->count - 1].degree;
+    for (int r = (n + m - 1) / stride - 1; r >= 0; r--) {
+        Coefficient coeff = combine_limbs(product + (size_t)r * stride, stride);
+        if (coefficient_sign(&coeff) != 0) append_term(result, low + r, coeff);
+    }
+    free(da);
+    free(db);
+    free(product);
+    return 1;
+}
+
+// 곱의 차수별 합을 모으는 열린 주소 해시 (빈 칸은 degree -1, 칸 수는 결과 항 수의 2~4배)
+typedef struct {
+    Term* slots;
+    size_t capacity; // 2의 거듭제곱
+    size_t used;
+    int shift;       // 64 - log2(capacity)
+} TermTable;
+
+static void init_table(TermTable* t, int bits) {
+    t->capacity = (size_t)1 << bits;
+    t->used = 0;
+    t->shift = 64 - bits;
+    t->slots = malloc(t->capacity * sizeof(Term));
+    if (!t->slots) {
+        fprintf(stderr, "메모리가 부족합니다 (항 %zu개)\n", t->capacity);
+        exit(1);
+    }
+    for (size_t i = 0; i < t->capacity; i++) {
+        t->slots[i].degree = -1;
+        t->slots[i].coeff.small = 0;
+        t->slots[i].coeff.big = NULL;
+    }
+}
+
+static Term* find_slot(TermTable* t, long long degree) {
+    size_t mask = t->capacity - 1;
+    size_t i = (size_t)(((unsigned long long)degree * 0x9E3779B97F4A7C15ULL) >> t->shift);
+    while (t->slots[i].degree != degree && t->slots[i].degree != -1) i = (i + 1) & mask;
+    return &t->slots[i];
+}
+
+// 칸 수를 두 배로 늘려 다시 넣음
+static void grow_table(TermTable* t) {
+    TermTable bigger;
+    init_table(&bigger, 65 - t->shift);
+    for (size_t i = 0; i < t->capacity; i++) {
+        if (t->slots[i].degree != -1) *find_slot(&bigger, t->slots[i].degree) = t->slots[i];
+    }
+    bigger.used = t->used;
+    free(t->slots);
+    *t = bigger;
+}
+
+// 모든 항의 쌍을 넘침 검사하며 곱해 차수별로 해시에 더한 뒤 정렬
+// (n·m개의 곱을 한꺼번에 모으지 않으므로 메모리는 결과 항 수에 비례)
+// 폭이 64비트여도 곱과 합은 128비트로 넘침을 검사하며 모으고 (큰 정수는 128비트를 넘을 때만),
+// 폭에 맞추는 것은 결과 항을 꺼낼 때 한 번만 함
+static void multiply_sparse(const Polynomial* a, const Polynomial* b, Polynomial* result) {
+    TermTable table;
+    init_table(&table, 6);
+    for (int i = 0; i < a->count; i++) {
+        for (int j = 0; j < b->count; j++) {
+            long long degree = a->terms[i].degree + b->terms[j].degree;
+            Coefficient product = coefficient_multiply(&a->terms[i].coeff, &b->terms[j].coeff);
+            Term* slot = find_slot(&table, degree);
+            if (slot->degree == -1) {
+                if (2 * (table.used + 1) > table.capacity) {
+                    grow_table(&table);
+                    slot = find_slot(&table, degree);
+                }
+                slot->degree = degree;
+                slot->coeff = product;
+                table.used++;
+            }
+            else {
+                coefficient_add_bits(&slot->coeff, &product, 128);
+                coefficient_free(&product);
+            }
+        }
+    }
+
+    reserve_terms(result, (long long)table.used);
+    for (size_t i = 0; i < table.capacity; i++) {
+        Term* slot = &table.slots[i];
+        if (slot->degree == -1) continue;
+        coefficient_fit(&slot->coeff);
+        if (coefficient_sign(&slot->coeff) != 0) append_term(result, slot->degree, slot->coeff);
+    }
+    free(table.slots);
+    normalize_polynomial(result); // 같은 차수는 없으므로 정렬만 함
+}
+
+// 펼친 배열로 곱하는 편이 싸면 밀집 커널로 곱하고 (결과가 int64에 들어가면 계수 그대로,
+// 아니면 자리로 나눠 multiply_wide로), 아니면 multiply_sparse로 곱함
+void multiply_polynomials(const Polynomial* a, const Polynomial* b, Polynomial* result) {
+    clear_polynomial(result);
+    if (a->count == 0 || b->count == 0) return;
+
+    if (product_fits_int64(a, b)) {
+        if (prefer_dense(a, b, 1, SPARSE_WEIGHT)) {
+            int n, m;
+            unsigned long long* da = expand_polynomial(a, &n);
+            unsigned long long* db = expand_polynomial(b, &m);
+            unsigned long long* product = malloc((n + m - 1) * sizeof(unsigned long long));
+            multiply_dense(da, n, db, m, product);
+            long long low = a->terms[a->count - 1].degree + b->terms[b->count - 1].degree;
+            for (int i = n + m - 2; i >= 0; i--) {
+                Coefficient coeff = { (long long)product[i], NULL };
+                if (coeff.small != 0) append_term(result, low + i, coeff);
+            }
+            free(da);
+            free(db);
+            free(product);
+            return;
+        }
+    }
+    else {
+        // multiply_sparse는 128비트 안이면 int64와 비슷한 비용으로 모으므로 그때는 같은 가중치로 비교
+        int bits_a = max_bit_length(a), bits_b = max_bit_length(b);
+        int count = a->count < b->count ? a->count : b->count, carry = 0;
+        while (carry < 32 && (1 << carry) < count) carry++;
+        int weight = bits_a + bits_b + carry < 127 ? SPARSE_WEIGHT : BIG_WEIGHT;
+        int limbs_a = (bits_a + LIMB_BITS - 1) / LIMB_BITS, limbs_b = (bits_b + LIMB_BITS - 1) / LIMB_BITS;
+        if (prefer_dense(a, b, limbs_a + limbs_b - 1, weight) && multiply_wide(a, limbs_a, b, limbs_b, result)) return;
+    }
+
+    multiply_sparse(a, b, result);
+}
+
+// -b: 길이별로 세 커널의 시간을 재고 결과가 교과서 방식과 같은지 확인한 뒤 임계값을 고름
+// (고른 값은 출력만 하고, 쓰려면 출력된 -k, -n을 붙여 실행)
+// 카라추바 임계값은 한 단계만 나눈 카라추바가 교과서 방식보다 빨라지는 길이,
+// NTT 임계값은 NTT가 (그 임계값을 쓴) 카라추바보다 빨라지는 결과 길이
+#define BENCH_SCHOOLBOOK_MAX (1 << 14) // 이보다 길면 교과서 방식은 재지 않고 카라추바와 NTT끼리 비교
+#define BENCH_MAX_LENGTH (1 << 16)
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64
+static unsigned long long next_random(unsigned long long* state) {
+    unsigned long long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// 짧은 길이는 여러 번 돌려 한 번당 시간을 잼
+static double time_kernel(void (*kernel)(const unsigned long long*, int, const unsigned long long*, int,
+                                         unsigned long long*),
+                          const unsigned long long* a, const unsigned long long* b, int n, unsigned long long* out) {
+    int repeat = 1;
+    for (;;) {
+        double t0 = now_seconds();
+        for (int r = 0; r < repeat; r++) kernel(a, n, b, n, out);
+        double elapsed = now_seconds() - t0;
+        if (elapsed > 0.02) return elapsed / repeat;
+        repeat *= 4;
+    }
+}
+
+int run_benchmark(void) {
+    int saved_karatsuba = karatsuba_threshold;
+    unsigned long long state = 88172645463325252ULL;
+    unsigned long long* a = malloc(BENCH_MAX_LENGTH * sizeof(unsigned long long));
+    unsigned long long* b = malloc(BENCH_MAX_LENGTH * sizeof(unsigned long long));
+    unsigned long long* expected = malloc(2 * BENCH_MAX_LENGTH * sizeof(unsigned long long));
+    unsigned long long* actual = malloc(2 * BENCH_MAX_LENGTH * sizeof(unsigned long long));
+    // int 전 범위의 계수를 써서 곱이 int를 넘쳐도 세 커널이 같은 값을 내는지 봄
+    for (int i = 0; i < BENCH_MAX_LENGTH; i++) {
+        a[i] = (unsigned long long)(long long)(int)next_random(&state);
+        b[i] = (unsigned long long)(long long)(int)next_random(&state);
+    }
+
+    printf("[곱셈 벤치마크] 두 다항식의 길이가 같을 때 곱 한 번의 시간\n");
+    int mismatches = 0;
+    int chosen_karatsuba = 0, chosen_ntt = 0;
+    for (int n = 4; n <= BENCH_MAX_LENGTH; n *= 2) {
+        int length = 2 * n - 1;
+        printf("  길이 %6d:", n);
+        if (n <= BENCH_SCHOOLBOOK_MAX) {
+            double schoolbook_time = time_kernel(multiply_schoolbook, a, b, n, expected);
+            karatsuba_threshold = n; // 한 단계만 나누고 나머지는 교과서 방식
+            double split_time = time_kernel(multiply_karatsuba, a, b, n, actual);
+            if (memcmp(actual, expected, length * sizeof(unsigned long long))) {
+                fprintf(stderr, "불일치: 길이 %d 카라추바 (한 단계)\n", n);
+                mismatches++;
+            }
+            if (!chosen_karatsuba && split_time < schoolbook_time) chosen_karatsuba = n;
+            karatsuba_threshold = chosen_karatsuba ? chosen_karatsuba : n + 1;
+            printf(" 교과서 %12.0f ns, 카라추바 한 단계 %12.0f ns,", schoolbook_time * 1e9, split_time * 1e9);
+        }
+
+        double karatsuba_time = time_kernel(multiply_karatsuba, a, b, n, actual);
+        if (n <= BENCH_SCHOOLBOOK_MAX) {
+            if (memcmp(actual, expected, length * sizeof(unsigned long long))) {
+                fprintf(stderr, "불일치: 길이 %d 카라추바\n", n);
+                mismatches++;
+            }
+        }
+        else {
+            // 교과서 방식은 너무 느리므로 작은 길이에서 검증한 카라추바를 기준으로 삼음
+            memcpy(expected, actual, length * sizeof(unsigned long long));
+        }
+        double ntt_time = time_kernel(multiply_ntt, a, b, n, actual);
+        if (memcmp(actual, expected, length * sizeof(unsigned long long))) {
+            fprintf(stderr, "불일치: 길이 %d NTT\n", n);
+            mismatches++;
+        }
+        if (!chosen_ntt && ntt_time < karatsuba_time) chosen_ntt = length;
+        printf(" 카라추바 %12.0f ns, NTT %12.0f ns\n", karatsuba_time * 1e9, ntt_time * 1e9);
+    }
+    chosen_karatsuba = chosen_karatsuba ? chosen_karatsuba : BENCH_SCHOOLBOOK_MAX;
+    chosen_ntt = chosen_ntt ? chosen_ntt : NTT_MAX_LENGTH;
+    printf("  선택한 임계값: 카라추바 %d, NTT %d (기본값 %d, %d)\n", chosen_karatsuba, chosen_ntt,
+           KARATSUBA_THRESHOLD, NTT_THRESHOLD);
+    printf("  이 기계에서 쓰려면: -k %d -n %d\n", chosen_karatsuba, chosen_ntt);
+    printf("  교과서 방식과 다른 결과 %d건\n", mismatches);
+    karatsuba_threshold = saved_karatsuba;
+
+    free(a);
+    free(b);
+    free(expected);
+    free(actual);
+    return mismatches != 0;
+}
+
+// 한 쌍을 처리할 때 쓰는 작업 공간 (스레드마다 하나)
+typedef struct {
+    Polynomial poly1, poly2, sum, product;
+} PairWorkspace;
+
+void init_workspace(PairWorkspace* ws) {
+    init_polynomial(&ws->poly1);
+    init_polynomial(&ws->poly2);
+    init_polynomial(&ws->sum);
+    init_polynomial(&ws->product);
+}
+
+void free_workspace(PairWorkspace* ws) {
+    free_polynomial(&ws->poly1);
+    free_polynomial(&ws->poly2);
+    free_polynomial(&ws->sum);
+    free_polynomial(&ws->product);
+}
+
+// pair번째 쌍의 결과를 out에 붙임 (두 줄은 개행을 뺀 것, 어느 한 줄이라도 틀리면 합과 곱은 생략)
+void process_pair(PairWorkspace* ws, const char* line1, size_t len1, const char* line2, size_t len2, int pair,
+                  OutputBuffer* out) {
+    char* dest = reserve_output(out, 64);
+    out->length += snprintf(dest, 64, "\n▶ [%d번째 다항식 쌍]\n", pair);
+
+    ParseError error1, error2;
+    int ok1 = parse_polynomial(line1, len1, &ws->poly1, &error1);
+    int ok2 = parse_polynomial(line2, len2, &ws->poly2, &error2);
+
+    append_string(out, "정리된 첫 번째 다항식: ");
+    if (ok1) append_polynomial(out, &ws->poly1);
+    else append_parse_error(out, line1, len1, &error1);
+    append_string(out, "정리된 두 번째 다항식: ");
+    if (ok2) append_polynomial(out, &ws->poly2);
+    else append_parse_error(out, line2, len2, &error2);
+    if (!ok1 || !ok2) return;
+
+    add_polynomials(&ws->poly1, &ws->poly2, &ws->sum);
+    append_string(out, "두 다항식의 합: ");
+    append_polynomial(out, &ws->sum);
+
+    multiply_polynomials(&ws->poly1, &ws->poly2, &ws->product);
+    append_string(out, "두 다항식의 곱: ");
+    append_polynomial(out, &ws->product);
+}
+
+#define OUTPUT_FLUSH_BYTES (256 * 1024)
+
+// 한 줄씩 읽어 순서대로 처리 (줄 길이에 한계가 없음)
+int process_file_sequential(FILE* file, FILE* output) {
+    char* lines[2] = { NULL, NULL };
+    size_t capacities[2] = { 0, 0 };
+    size_t lengths[2];
+    int read_count = 0;
+    int pair = 1;
+    PairWorkspace* ws = malloc(sizeof(PairWorkspace));
+    init_workspace(ws);
+    OutputBuffer out;
+    init_output(&out);
+
+    ssize_t got;
+    while ((got = getline(&lines[read_count], &capacities[read_count], file)) > 0) {
+        size_t len = text_length(lines[read_count], (size_t)got);
+        if (is_blank_line(lines[read_count], len)) continue;
+
+        lengths[read_count] = len;
+        if (read_count == 0) {
+            read_count = 1;
+        }
+        else {
+            read_count = 0;
+            process_pair(ws, lines[0], lengths[0], lines[1], lengths[1], pair++, &out);
+            if (out.length >= OUTPUT_FLUSH_BYTES) flush_output(&out, output);
+        }
+    }
+    flush_output(&out, output);
+
+    free_output(&out);
+    free_workspace(ws);
+    free(ws);
+    free(lines[0]);
+    free(lines[1]);
+    return 0;
+}
+
+// 일괄 처리 모드 (-j): 파일을 큰 블록으로 읽어 쌍 목록을 만들고, 쌍 묶음을 여러 스레드가 묶음별 버퍼에
+// 쓰면 메인 스레드가 원래 순서대로 내보냄
+#define READ_BLOCK (1 << 20)
+#define PAIR_GROUP 256   // 스레드가 한 번에 가져가는 쌍 수
+#define GROUP_WINDOW 64  // 아직 내보내지 않은 묶음이 이만큼 쌓이면 작업 스레드가 기다림
+
+// 줄 끝 개행을 뗀 두 줄 (입력 데이터를 가리킴)
+typedef struct {
+    const char* text[2];
+    size_t length[2];
+} LinePair;
+
+typedef struct {
+    int first; // 첫 쌍의 번호 (0부터)
+    int count;
+    int done;
+    OutputBuffer out;
+} PairGroup;
+
+typedef struct {
+    const LinePair* pairs;
+    PairGroup* groups;
+    int group_count;
+    int next_group;    // 다음에 가져갈 묶음
+    int written_group; // 이 번호 앞의 묶음은 모두 출력됨
+    pthread_mutex_t lock;
+    pthread_cond_t group_done;
+    pthread_cond_t group_written;
+} BatchJob;
+
+static void* batch_worker(void* arg) {
+    BatchJob* job = arg;
+    PairWorkspace* ws = malloc(sizeof(PairWorkspace));
+    init_workspace(ws);
+
+    pthread_mutex_lock(&job->lock);
+    while (job->next_group < job->group_count) {
+        int index = job->next_group;
+        if (index >= job->written_group + GROUP_WINDOW) {
+            pthread_cond_wait(&job->group_written, &job->lock);
+            continue;
+        }
+        job->next_group++;
+        pthread_mutex_unlock(&job->lock);
+
+        PairGroup* group = &job->groups[index];
+        for (int k = 0; k < group->count; k++) {
+            const LinePair* pair = &job->pairs[group->first + k];
+            process_pair(ws, pair->text[0], pair->length[0], pair->text[1], pair->length[1], group->first + k + 1,
+                         &group->out);
+        }
+
+        pthread_mutex_lock(&job->lock);
+        group->done = 1;
+        pthread_cond_broadcast(&job->group_done);
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    free_workspace(ws);
+    free(ws);
+    return NULL;
+}
+
+// 파일 전체를 READ_BLOCK 단위로 읽음
+static char* read_all(FILE* file, size_t* size) {
+    size_t capacity = READ_BLOCK, length = 0, got;
+    char* data = malloc(capacity);
+    while ((got = fread(data + length, 1, capacity - length, file)) > 0) {
+        length += got;
+        if (length == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    *size = length;
+    return data;
+}
+
+// 입력 전체를 num_threads개 스레드로 처리 (0 이하이면 CPU 코어 수)
+int process_file_parallel(FILE* file, int num_threads, FILE* output) {
+    size_t size;
+    char* data = read_all(file, &size);
+
+    // 줄 단위로 자르고 빈 줄을 빼며 두 줄씩 묶음
+    int pair_count = 0, pair_capacity = 1024, read_count = 0;
+    LinePair* pairs = malloc(pair_capacity * sizeof(LinePair));
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        const char* newline = memchr(p, '\n', end - p);
+        const char* line = p;
+        size_t len = text_length(line, newline ? (size_t)(newline - p) : (size_t)(end - p));
+        p = newline ? newline + 1 : end;
+
+        if (is_blank_line(line, len)) continue;
+        if (read_count == 0 && pair_count == pair_capacity) {
+            pair_capacity *= 2;
+            pairs = realloc(pairs, pair_capacity * sizeof(LinePair));
+        }
+        pairs[pair_count].text[read_count] = line;
+        pairs[pair_count].length[read_count] = len;
+        if (++read_count == 2) {
+            read_count = 0;
+            pair_count++;
+        }
+    }
+
+    if (num_threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        num_threads = cores > 0 ? (int)cores : 1;
+    }
+
+    BatchJob job;
+    job.pairs = pairs;
+    job.group_count = (pair_count + PAIR_GROUP - 1) / PAIR_GROUP;
+    job.groups = calloc(job.group_count + 1, sizeof(PairGroup));
+    for (int g = 0; g < job.group_count; g++) {
+        job.groups[g].first = g * PAIR_GROUP;
+        job.groups[g].count = pair_count - g * PAIR_GROUP < PAIR_GROUP ? pair_count - g * PAIR_GROUP : PAIR_GROUP;
+        init_output(&job.groups[g].out);
+    }
+    job.next_group = 0;
+    job.written_group = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.group_done, NULL);
+    pthread_cond_init(&job.group_written, NULL);
+
+    pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
+    int started = 0;
+    for (int t = 0; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, batch_worker, &job) != 0) break;
+        started++;
+    }
+    if (started == 0) batch_worker(&job);
+
+    // 끝난 묶음을 순서대로 내보냄
+    pthread_mutex_lock(&job.lock);
+    while (job.written_group < job.group_count) {
+        PairGroup* group = &job.groups[job.written_group];
+        if (!group->done) {
+            pthread_cond_wait(&job.group_done, &job.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&job.lock);
+        flush_output(&group->out, output);
+        free_output(&group->out);
+        pthread_mutex_lock(&job.lock);
+        job.written_group++;
+        pthread_cond_broadcast(&job.group_written);
+    }
+    pthread_mutex_unlock(&job.lock);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.group_done);
+    pthread_cond_destroy(&job.group_written);
+    free(job.groups);
+    free(pairs);
+    free(data);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int benchmark = 0;
+    int num_threads = -1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-b")) {
+            benchmark = 1;
+        }
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc && (!strcmp(argv[i + 1], "64") || !strcmp(argv[i + 1], "128"))) {
+            coefficient_bits = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            karatsuba_threshold = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            ntt_threshold = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "사용법: %s [-w 64|128] [-j 스레드수] [-k 카라추바임계값] [-n NTT임계값] | %s -b\n",
+                    argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (benchmark) return run_benchmark();
+
+    FILE* file = fopen("input.txt", "r");
+    if (!file) {
+        printf("파일을 열 수 없습니다.\n");
+        return 1;
+    }
+
+    int status = num_threads >= 0 ? process_file_parallel(file, num_threads, stdout)
+                                  : process_file_sequential(file, stdout);
+    fclose(file);
+    return status;
+}
@@ -1,371 +1,2158 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#define MAX_N 1000
-#define INF 999999
-
-// 인접 리스트의 노드 구조체
-typedef struct AdjNode {
-    int vertex;
-    struct AdjNode* next;
-} AdjNode;
-
-// 그래프 구조체
-typedef struct Graph {
-    int numVertices;
-    AdjNode** adjList;
-} Graph;
-
-// 그래프 초기화
-Graph* createGraph(int vertices) {
-    Graph* graph = (Graph*)malloc(sizeof(Graph));
-    graph->numVertices = vertices;
-    graph->adjList = (AdjNode**)malloc((vertices + 1) * sizeof(AdjNode*));
-    
-    // 모든 인접 리스트를 NULL로 초기화 (1번부터 시작하므로 vertices+1)
-    for (int i = 0; i <= vertices; i++) {
-        graph->adjList[i] = NULL;
-    }
-    
-    return graph;
-}
-
-// 새로운 인접 노드 생성
-AdjNode* createAdjNode(int vertex) {
-    AdjNode* newNode = (AdjNode*)malloc(sizeof(AdjNode));
-    newNode->vertex = vertex;
-    newNode->next = NULL;
-    return newNode;
-}
-
-// 단방향 간선 추가 (중복 방지를 위해)
-void addEdge(Graph* graph, int src, int dest) {
-    AdjNode* newNode = createAdjNode(dest);
-    newNode->next = graph->adjList[src];
-    graph->adjList[src] = newNode;
-}
-
-// 파일에서 그래프 읽기
-Graph* readGraphFromFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("파일을 열 수 없습니다: %s\n", filename);
-        return NULL;
-    }
-    
-    int numVertices;
-    fscanf(file, "%d", &numVertices);
-    
-    Graph* graph = createGraph(numVertices);
-    
-    char line[1000];
-    fgets(line, sizeof(line), file); // 첫 줄의 개행문자 처리
-    
-    // 각 줄을 읽어서 연결 정보 파싱
-    while (fgets(line, sizeof(line), file)) {
-        char* token = strtok(line, " \n");
-        if (!token) continue;
-        
-        int src = atoi(token);
-        
-        // 나머지 토큰들은 연결된 노드들
-        while ((token = strtok(NULL, " \n")) != NULL) {
-            int dest = atoi(token);
-            addEdge(graph, src, dest);
-        }
-    }
-    
-    fclose(file);
-    return graph;
-}
-
-// 그래프 출력 (디버깅용)
-void printGraph(Graph* graph) {
-    for (int i = 1; i <= graph->numVertices; i++) {
-        printf("%d: ", i);
-        AdjNode* temp = graph->adjList[i];
-        while (temp) {
-            printf("%d ", temp->vertex);
-            temp = temp->next;
-        }
-        printf("\n");
-    }
-}
-
-// 큐 구조체 (BFS용)
-typedef struct Queue {
-    int items[MAX_N];
-    int front;
-    int rear;
-} Queue;
-
-// 큐 초기화
-Queue* createQueue() {
-    Queue* q = (Queue*)malloc(sizeof(Queue));
-    q->front = -1;
-    q->rear = -1;
-    return q;
-}
-
-// 큐가 비어있는지 확인
-int isEmpty(Queue* q) {
-    return q->rear == -1;
-}
-
-// 큐에 요소 추가
-void enqueue(Queue* q, int value) {
-    if (q->rear == MAX_N - 1) {
-        printf("큐가 가득 참\n");
-    } else {
-        if (q->front == -1) {
-            q->front = 0;
-        }
-        q->rear++;
-        q->items[q->rear] = value;
-    }
-}
-
-// 큐에서 요소 제거
-int dequeue(Queue* q) {
-    if (isEmpty(q)) {
-        printf("큐가 비어있음\n");
-        return -1;
-    } else {
-        int item = q->items[q->front];
-        q->front++;
-        if (q->front > q->rear) {
-            q->front = q->rear = -1;
-        }
-        return item;
-    }
-}
-
-// BFS로 시작 노드에서 모든 노드까지의 거리 계산
-int* bfs(Graph* graph, int start) {
-    int* dist = (int*)malloc((graph->numVertices + 1) * sizeof(int));
-    int* visited = (int*)malloc((graph->numVertices + 1) * sizeof(int));
-    
-    // 초기화
-    for (int i = 1; i <= graph->numVertices; i++) {
-        dist[i] = INF;
-        visited[i] = 0;
-    }
-    
-    Queue* q = createQueue();
-    
-    dist[start] = 0;
-    visited[start] = 1;
-    enqueue(q, start);
-    
-    while (!isEmpty(q)) {
-        int current = dequeue(q);
-        
-        AdjNode* temp = graph->adjList[current];
-        while (temp) {
-            int neighbor = temp->vertex;
-            if (!visited[neighbor]) {
-                visited[neighbor] = 1;
-                dist[neighbor] = dist[current] + 1;
-                enqueue(q, neighbor);
-            }
-            temp = temp->next;
-        }
-    }
-    
-    free(visited);
-    free(q);
-    return dist;
-}
-
-// 두 노드 간의 최단 거리 계산
-int getDistance(Graph* graph, int src, int dest) {
-    int* dist = bfs(graph, src);
-    int result = dist[dest];
-    free(dist);
-    return result == INF ? -1 : result;
-}
-
-// (1) 나와 너의 거리는? - 67번과 26번 사이의 거리
-void question1(Graph* graph) {
-    int dist = getDistance(graph, 67, 26);
-    printf("(1) 67번과 26번 사이의 거리: %d\n", dist);
-}
-
-// (2) Lone Wolf는? - 연결된 컴포넌트의 수 계산
-int countComponents(Graph* graph) {
-    int* visited = (int*)malloc((graph->numVertices + 1) * sizeof(int));
-    int components = 0;
-    
-    // 초기화
-    for (int i = 1; i <= graph->numVertices; i++) {
-        visited[i] = 0;
-    }
-    
-    // 각 노드에서 DFS 시작
-    for (int i = 1; i <= graph->numVertices; i++) {
-        if (!visited[i]) {
-            // 새로운 컴포넌트 발견
-            components++;
-            
-            // DFS로 연결된 모든 노드 방문 표시
-            int* stack = (int*)malloc(graph->numVertices * sizeof(int));
-            int top = 0;
-            stack[top] = i;
-            
-            while (top >= 0) {
-                int current = stack[top--];
-                if (!visited[current]) {
-                    visited[current] = 1;
-                    
-                    AdjNode* temp = graph->adjList[current];
-                    while (temp) {
-                        if (!visited[temp->vertex]) {
-                            stack[++top] = temp->vertex;
-                        }
-                        temp = temp->next;
-                    }
-                }
-            }
-            free(stack);
-        }
-    }
-    
-    free(visited);
-    return components;
-}
-
-void question2(Graph* graph) {
-    int components = countComponents(graph);
-    printf("(2) 연결된 컴포넌트 수 (Lone Wolf): %d\n", components);
-}
-
-// (3) 3단계 이내에 가장 많은 사람에게 도달할 수 있는 사람
-int countReachable(Graph* graph, int start, int maxDist) {
-    int* dist = bfs(graph, start);
-    int count = 0;
-    
-    for (int i = 1; i <= graph->numVertices; i++) {
-        if (dist[i] <= maxDist) {
-            count++;
-        }
-    }
-    
-    free(dist);
-    return count;
-}
-
-void question3(Graph* graph) {
-    int bestPerson = 1;
-    int maxReachable = 0;
-    
-    for (int i = 1; i <= graph->numVertices; i++) {
-        int reachable = countReachable(graph, i, 3);
-        if (reachable > maxReachable) {
-            maxReachable = reachable;
-            bestPerson = i;
-        }
-    }
-    
-    printf("(3) 3단계 이내에 가장 많은 사람(%d명)에게 도달 가능한 사람: %d번\n", 
-           maxReachable, bestPerson);
-}
-
-// (4) 3단계 이내로 모든 사람에게 연락하기 위한 최소 인원 조합
-void question4(Graph* graph) {
-    int* covered = (int*)malloc((graph->numVertices + 1) * sizeof(int));
-    int* selected = (int*)malloc((graph->numVertices + 1) * sizeof(int));
-    int selectedCount = 0;
-    
-    // 초기화
-    for (int i = 1; i <= graph->numVertices; i++) {
-        covered[i] = 0;
-        selected[i] = 0;
-    }
-    
-    // 그리디 방식: 매번 가장 많은 미커버 노드를 커버하는 노드 선택
-    while (1) {
-        int bestNode = -1;
-        int bestNewCovered = 0;
-        
-        // 각 노드에 대해 새로 커버할 수 있는 노드 수 계산
-        for (int i = 1; i <= graph->numVertices; i++) {
-            if (selected[i]) continue;
-            
-            int* dist = bfs(graph, i);
-            int newCovered = 0;
-            
-            for (int j = 1; j <= graph->numVertices; j++) {
-                if (!covered[j] && dist[j] <= 3) {
-                    newCovered++;
-                }
-            }
-            
-            if (newCovered > bestNewCovered) {
-                bestNewCovered = newCovered;
-                bestNode = i;
-            }
-            
-            free(dist);
-        }
-        
-        if (bestNode == -1 || bestNewCovered == 0) break;
-        
-        // 선택된 노드로 커버 업데이트
-        selected[bestNode] = 1;
-        selectedCount++;
-        
-        int* dist = bfs(graph, bestNode);
-        for (int j = 1; j <= graph->numVertices; j++) {
-            if (dist[j] <= 3) {
-                covered[j] = 1;
-            }
-        }
-        free(dist);
-    }
-    
-    printf("(4) 3단계 이내 전체 커버를 위한 최소 인원(%d명): ", selectedCount);
-    for (int i = 1; i <= graph->numVertices; i++) {
-        if (selected[i]) {
-            printf("%d ", i);
-        }
-    }
-    printf("\n");
-    
-    free(covered);
-    free(selected);
-}
-
-// 메인 함수
-int main() {
-    printf("=== 케빈 베이컨 게임 ===\n");
-    
-    // 그래프 파일 읽기
-    Graph* graph = readGraphFromFile("kb.txt");
-    if (!graph) {
-        printf("그래프를 읽을 수 없습니다.\n");
-        return 1;
-    }
-    
-    printf("그래프 로드 완료: %d명의 사람\n\n", graph->numVertices);
-    
-    // 4가지 질문 해결
-    question1(graph);
-    question2(graph);
-    question3(graph);
-    question4(graph);
-    
-    // 메모리 해제
-    for (int i = 1; i <= graph->numVertices; i++) {
-        AdjNode* temp = graph->adjList[i];
-        while (temp) {
-            AdjNode* toDelete = temp;
-            temp = temp->next;
-            free(toDelete);
-        }
-    }
-    free(graph->adjList);
-    free(graph);
-    
-    return 0;
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INF 999999
+
+// 간선 목록 (CSR 생성 전 임시로 간선을 모아두는 빌더)
+typedef struct EdgeList {
+    int count;
+    int capacity;
+    int* src;
+    int* dest;
+} EdgeList;
+
+// 그래프 구조체 (CSR: v의 이웃은 adj[offsets[v]] ~ adj[offsets[v + 1] - 1])
+typedef struct Graph {
+    int numVertices;
+    int numEdges;
+    int* offsets;   // 1번부터 시작하므로 크기는 numVertices + 2
+    int* adj;       // 모든 이웃을 정점 순서대로 이어 붙인 배열
+    void* mapping;  // 스냅샷에서 매핑한 경우 매핑 시작 주소 (아니면 NULL)
+    size_t mappingSize;
+    int* revOffsets; // 역방향 CSR (상향식 BFS용, 필요할 때 buildReverseGraph로 생성)
+    int* revAdj;
+    int* componentParent; // 유니온 파인드 부모 (텍스트를 읽을 때 함께 계산, 없으면 NULL)
+} Graph;
+
+// 간선 목록 초기화
+EdgeList* createEdgeList(int capacity) {
+    EdgeList* edges = (EdgeList*)malloc(sizeof(EdgeList));
+    if (capacity < 16) capacity = 16;
+    edges->count = 0;
+    edges->capacity = capacity;
+    edges->src = (int*)malloc(capacity * sizeof(int));
+    edges->dest = (int*)malloc(capacity * sizeof(int));
+    return edges;
+}
+
+void freeEdgeList(EdgeList* edges) {
+    free(edges->src);
+    free(edges->dest);
+    free(edges);
+}
+
+// 단방향 간선 추가 (공간이 부족하면 두 배로 늘림)
+void addEdge(EdgeList* edges, int src, int dest) {
+    if (edges->count == edges->capacity) {
+        edges->capacity *= 2;
+        edges->src = (int*)realloc(edges->src, edges->capacity * sizeof(int));
+        edges->dest = (int*)realloc(edges->dest, edges->capacity * sizeof(int));
+    }
+    edges->src[edges->count] = src;
+    edges->dest[edges->count] = dest;
+    edges->count++;
+}
+
+// 간선 목록으로 CSR 그래프 생성 (1차: 차수 세기, 2차: 이웃 채우기)
+Graph* buildGraph(int vertices, const EdgeList* edges) {
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    graph->numVertices = vertices;
+    graph->numEdges = edges->count;
+    graph->offsets = (int*)calloc(vertices + 2, sizeof(int));
+    graph->adj = (int*)malloc((edges->count > 0 ? edges->count : 1) * sizeof(int));
+
+    // 1차: offsets[v + 1]에 v의 차수를 센 뒤 누적합으로 시작 위치 계산
+    for (int i = 0; i < edges->count; i++) {
+        graph->offsets[edges->src[i] + 1]++;
+    }
+    for (int v = 1; v <= vertices; v++) {
+        graph->offsets[v + 1] += graph->offsets[v];
+    }
+
+    // 2차: 각 정점의 다음 빈 칸에 이웃을 채움
+    int* next = (int*)malloc((vertices + 1) * sizeof(int));
+    memcpy(next, graph->offsets, (vertices + 1) * sizeof(int));
+    for (int i = 0; i < edges->count; i++) {
+        graph->adj[next[edges->src[i]]++] = edges->dest[i];
+    }
+    free(next);
+
+    return graph;
+}
+
+// 그래프 메모리 해제
+void freeGraph(Graph* graph) {
+    if (graph->mapping) {
+        munmap(graph->mapping, graph->mappingSize);
+    } else {
+        free(graph->offsets);
+        free(graph->adj);
+    }
+    free(graph->revOffsets);
+    free(graph->revAdj);
+    free(graph->componentParent);
+    free(graph);
+}
+
+// 역방향 CSR 생성 (u → v 간선을 v의 들어오는 이웃 u로 저장, 이미 있으면 그대로 사용)
+void buildReverseGraph(Graph* graph) {
+    if (graph->revOffsets) return;
+    
+    int n = graph->numVertices;
+    graph->revOffsets = (int*)calloc(n + 2, sizeof(int));
+    graph->revAdj = (int*)malloc((graph->numEdges > 0 ? graph->numEdges : 1) * sizeof(int));
+    
+    for (int e = 0; e < graph->numEdges; e++) {
+        graph->revOffsets[graph->adj[e] + 1]++;
+    }
+    for (int v = 1; v <= n; v++) {
+        graph->revOffsets[v + 1] += graph->revOffsets[v];
+    }
+    
+    int* next = (int*)malloc((n + 1) * sizeof(int));
+    memcpy(next, graph->revOffsets, (n + 1) * sizeof(int));
+    for (int u = 1; u <= n; u++) {
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            graph->revAdj[next[graph->adj[e]]++] = u;
+        }
+    }
+    free(next);
+}
+
+// 유니온 파인드의 루트 찾기 (경로 절반 압축: 지나가는 정점이 조부모를 가리키게 함)
+// 여러 스레드가 함께 써도 되도록 부모 배열은 원자적으로 읽고 씀
+static inline int findRoot(int* parent, int v) {
+    while (1) {
+        int p = __atomic_load_n(&parent[v], __ATOMIC_RELAXED);
+        int grandparent = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+        if (p == grandparent) return p;
+        __atomic_store_n(&parent[v], grandparent, __ATOMIC_RELAXED);
+        v = grandparent;
+    }
+}
+
+// a와 b가 속한 집합을 합침
+// 항상 번호가 큰 루트를 작은 루트 밑에 달기 때문에 동시에 합쳐도 순환이 생기지 않고
+// 루트는 언제나 그 컴포넌트에서 가장 작은 정점 번호가 됨
+static inline void uniteVertices(int* parent, int a, int b) {
+    while (1) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a > b) {
+            int t = a;
+            a = b;
+            b = t;
+        }
+        int expected = b;
+        if (__atomic_compare_exchange_n(&parent[b], &expected, a, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+    }
+}
+
+// 공백 문자인지 확인 (줄바꿈은 줄 구분이므로 제외)
+static inline int isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// p에서 시작하는 토큰 하나를 atoi처럼 정수로 읽고 토큰 끝 위치를 반환
+static inline const char* parseToken(const char* p, const char* end, long long* value) {
+    long long v = 0;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    while (p < end && (unsigned)(*p - '0') < 10) {
+        if (v < INT_MAX) v = v * 10 + (*p - '0');
+        p++;
+    }
+    // atoi와 같이 숫자 뒤에 붙은 나머지 문자는 무시
+    while (p < end && *p != '\n' && !isBlank(*p)) p++;
+    *value = negative ? -v : v;
+    return p;
+}
+
+// 매핑된 인접 리스트 텍스트를 한 번 훑음
+// adj가 NULL이면 offsets[src + 1]에 차수만 세고 (INT_MAX에서 멈춤), 아니면 next[src] 위치에 이웃을 채움
+static void scanAdjacency(const char* p, const char* end, int numVertices,
+                          int* offsets, int* next, int* adj) {
+    while (p < end) {
+        // 줄의 첫 토큰이 출발 정점
+        while (p < end && isBlank(*p)) p++;
+        if (p == end) break;
+        if (*p == '\n') {
+            p++;
+            continue;
+        }
+
+        long long src;
+        p = parseToken(p, end, &src);
+        int validSrc = src >= 1 && src <= numVertices;
+        long long count = 0;
+        int* out = (adj && validSrc) ? adj + next[src] : NULL;
+
+        // 나머지 토큰들은 연결된 노드들 (줄 길이 제한 없음)
+        while (p < end && *p != '\n') {
+            if (isBlank(*p)) {
+                p++;
+                continue;
+            }
+            long long dest;
+            p = parseToken(p, end, &dest);
+            if (!validSrc || dest < 1 || dest > numVertices) continue;
+            if (out) out[count] = (int)dest;
+            count++;
+        }
+
+        if (!validSrc) continue;
+        if (adj) {
+            next[src] += (int)count;
+        } else {
+            offsets[src + 1] = (int)(count < INT_MAX - offsets[src + 1] ? offsets[src + 1] + count : INT_MAX);
+        }
+    }
+}
+
+// 파일에서 그래프 읽기 (mmap으로 파일을 복사 없이 두 번 훑어 CSR을 바로 채움)
+Graph* readGraphFromFile(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("파일을 열 수 없습니다: %s\n", filename);
+        return NULL;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        printf("파일을 열 수 없습니다: %s\n", filename);
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE; // 두 번 훑으므로 페이지를 미리 올려 페이지 폴트를 줄임
+#endif
+    const char* data = (const char*)mmap(NULL, size, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("파일을 열 수 없습니다: %s\n", filename);
+        return NULL;
+    }
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+    
+    const char* p = data;
+    const char* end = data + size;
+    
+    // 첫 토큰은 정점 수, 첫 줄의 나머지는 무시
+    while (p < end && (isBlank(*p) || *p == '\n')) p++;
+    long long numVertices = 0;
+    p = parseToken(p, end, &numVertices);
+    if (numVertices < 1) {
+        printf("정점 수를 읽을 수 없습니다: %s\n", filename);
+        munmap((void*)data, size);
+        return NULL;
+    }
+    // offsets[numVertices + 1]과 v + 1 반복이 int 안에 있어야 함 (스냅샷과 같은 한도)
+    if (numVertices > INT_MAX - 2) {
+        printf("정점 수가 너무 큽니다: %s\n", filename);
+        munmap((void*)data, size);
+        return NULL;
+    }
+    while (p < end && *p != '\n') p++;
+    
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    if (!graph || !(graph->offsets = (int*)calloc(numVertices + 2, sizeof(int)))) {
+        printf("메모리가 부족합니다: %s\n", filename);
+        free(graph);
+        munmap((void*)data, size);
+        return NULL;
+    }
+    graph->numVertices = (int)numVertices;
+    
+    // 1차: 차수를 세어 CSR 배열 크기 결정 (간선 수 합이 int를 넘으면 CSR로 나타낼 수 없음)
+    scanAdjacency(p, end, graph->numVertices, graph->offsets, NULL, NULL);
+    for (int v = 1; v <= graph->numVertices; v++) {
+        long long total = (long long)graph->offsets[v + 1] + graph->offsets[v];
+        if (total > INT_MAX) {
+            printf("간선이 너무 많습니다: %s\n", filename);
+            freeGraph(graph);
+            munmap((void*)data, size);
+            return NULL;
+        }
+        graph->offsets[v + 1] = (int)total;
+    }
+    graph->numEdges = graph->offsets[graph->numVertices + 1];
+    graph->adj = (int*)malloc((graph->numEdges > 0 ? (size_t)graph->numEdges : 1) * sizeof(int));
+    
+    // 2차: 이웃 채우기
+    int* next = (int*)malloc((numVertices + 1) * sizeof(int));
+    if (!graph->adj || !next) {
+        printf("메모리가 부족합니다: %s\n", filename);
+        free(next);
+        freeGraph(graph);
+        munmap((void*)data, size);
+        return NULL;
+    }
+    memcpy(next, graph->offsets, (numVertices + 1) * sizeof(int));
+    scanAdjacency(p, end, graph->numVertices, graph->offsets, next, graph->adj);
+    free(next);
+    munmap((void*)data, size);
+    
+    // 간선을 유니온 파인드로 합쳐 연결 컴포넌트를 미리 계산
+    // (텍스트를 훑는 반복문 안에서 합치면 매핑 페이지가 부모 배열을 캐시에서 밀어내 더 느림)
+    graph->componentParent = (int*)malloc((numVertices + 1) * sizeof(int));
+    if (!graph->componentParent) {
+        printf("메모리가 부족합니다: %s\n", filename);
+        freeGraph(graph);
+        return NULL;
+    }
+    for (int v = 0; v <= graph->numVertices; v++) {
+        graph->componentParent[v] = v;
+    }
+    for (int v = 1; v <= graph->numVertices; v++) {
+        for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+            uniteVertices(graph->componentParent, v, graph->adj[e]);
+        }
+    }
+    return graph;
+}
+
+// 바이너리 스냅샷 헤더 (뒤에 offsets[numVertices + 2], adj[numEdges]가 int32로 이어짐)
+// 바이트 순서는 저장한 기계를 따르므로 같은 기계에서 다시 읽는 용도로 사용
+#define SNAPSHOT_MAGIC "KBGRAPH"
+#define SNAPSHOT_VERSION 2
+
+typedef struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int64_t numVertices;
+    int64_t numEdges;
+    uint64_t checksum;  // offsets와 adj 전체의 체크섬
+    int64_t sourceSize;       // 스냅샷을 만든 원본 파일의 크기와
+    int64_t sourceMtimeSec;   // 수정 시각 (초, 나노초), 다시 읽을 때 정확히 같아야 함
+    int64_t sourceMtimeNsec;
+} SnapshotHeader;
+
+// offsets와 adj를 32비트 단위로 섞는 FNV-1a 방식 체크섬
+static uint64_t graphChecksum(const Graph* graph) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int v = 0; v <= graph->numVertices + 1; v++) {
+        h = (h ^ (uint32_t)graph->offsets[v]) * 1099511628211ULL;
+    }
+    for (int e = 0; e < graph->numEdges; e++) {
+        h = (h ^ (uint32_t)graph->adj[e]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// 그래프를 스냅샷 파일로 저장 (임시 파일에 쓴 뒤 이름을 바꿔 중간 상태가 남지 않게 함)
+// source는 원본 파일의 stat (없으면 NULL)
+int writeGraphSnapshot(const Graph* graph, const char* filename, const struct stat* source) {
+    char tmpName[4096];
+    snprintf(tmpName, sizeof(tmpName), "%s.tmp", filename);
+    
+    FILE* file = fopen(tmpName, "wb");
+    if (!file) {
+        printf("스냅샷 파일을 만들 수 없습니다: %s\n", tmpName);
+        return 0;
+    }
+    
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.numVertices = graph->numVertices;
+    header.numEdges = graph->numEdges;
+    header.checksum = graphChecksum(graph);
+    if (source) {
+        header.sourceSize = source->st_size;
+        header.sourceMtimeSec = source->st_mtim.tv_sec;
+        header.sourceMtimeNsec = source->st_mtim.tv_nsec;
+    }
+    
+    size_t numOffsets = (size_t)graph->numVertices + 2;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(graph->offsets, sizeof(int), numOffsets, file) == numOffsets &&
+             fwrite(graph->adj, sizeof(int), (size_t)graph->numEdges, file) == (size_t)graph->numEdges;
+    ok = (fclose(file) == 0) && ok;
+    
+    if (!ok || rename(tmpName, filename) != 0) {
+        printf("스냅샷 파일을 쓸 수 없습니다: %s\n", filename);
+        remove(tmpName);
+        return 0;
+    }
+    return 1;
+}
+
+// 스냅샷 파일을 읽기 전용으로 매핑 (파싱 없이 offsets/adj가 매핑을 직접 가리킴)
+// source가 NULL이 아니면 헤더에 기록된 원본의 크기와 수정 시각이 같을 때만 사용
+// verify가 0이 아니면 전체 체크섬까지 확인하고, 아니면 헤더와 크기, offsets와 adj의 범위만 확인
+Graph* loadGraphSnapshot(const char* filename, int verify, const struct stat* source) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    
+    const SnapshotHeader* header = (const SnapshotHeader*)data;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION ||
+        header->headerSize != sizeof(SnapshotHeader) ||
+        header->numVertices < 1 || header->numVertices > INT_MAX - 2 ||
+        header->numEdges < 0 || header->numEdges > INT_MAX ||
+        size != sizeof(SnapshotHeader) +
+                ((size_t)header->numVertices + 2 + (size_t)header->numEdges) * sizeof(int)) {
+        printf("스냅샷 형식이 올바르지 않습니다: %s\n", filename);
+        munmap(data, size);
+        return NULL;
+    }
+    if (source && (header->sourceSize != source->st_size ||
+                   header->sourceMtimeSec != source->st_mtim.tv_sec ||
+                   header->sourceMtimeNsec != source->st_mtim.tv_nsec)) {
+        munmap(data, size);
+        return NULL;
+    }
+    
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    graph->numVertices = (int)header->numVertices;
+    graph->numEdges = (int)header->numEdges;
+    graph->offsets = (int*)((char*)data + sizeof(SnapshotHeader));
+    graph->adj = graph->offsets + graph->numVertices + 2;
+    graph->mapping = data;
+    graph->mappingSize = size;
+    
+    // BFS와 union-find가 offsets로 adj를 읽고 adj 값으로 정점 배열을 인덱싱하므로 체크섬을 건너뛰어도
+    // offsets가 [0, numEdges] 안에서 줄어들지 않는지, adj가 [1, numVertices] 안인지는 확인 (O(V+E))
+    int valid = graph->offsets[0] >= 0 &&
+                graph->offsets[graph->numVertices + 1] == graph->numEdges;
+    for (int v = 0; valid && v <= graph->numVertices; v++) {
+        valid = graph->offsets[v] <= graph->offsets[v + 1];
+    }
+    for (int e = 0; valid && e < graph->numEdges; e++) {
+        valid = graph->adj[e] >= 1 && graph->adj[e] <= graph->numVertices;
+    }
+    
+    if (!valid || (verify && graphChecksum(graph) != header->checksum)) {
+        printf("스냅샷이 손상되었습니다: %s\n", filename);
+        freeGraph(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+// 스냅샷에 기록된 원본의 크기와 수정 시각 (나노초까지)이 지금 원본과 같으면 스냅샷을 매핑하고,
+// 아니면 원본을 읽은 뒤 스냅샷을 새로 씀 (원본이 없으면 스냅샷을 그대로 사용)
+Graph* loadGraph(const char* filename, const char* snapshotName, int verify) {
+    if (!snapshotName) return readGraphFromFile(filename);
+    
+    struct stat textStat;
+    int haveText = stat(filename, &textStat) == 0;
+    Graph* graph = loadGraphSnapshot(snapshotName, verify, haveText ? &textStat : NULL);
+    if (graph) return graph;
+    
+    graph = readGraphFromFile(filename);
+    if (graph) writeGraphSnapshot(graph, snapshotName, haveText ? &textStat : NULL);
+    return graph;
+}
+
+// 벤치마크용 무작위 무방향 그래프 생성 (평균 차수 avgDegree, 같은 seed면 같은 그래프)
+Graph* generateRandomGraph(int vertices, int avgDegree, uint64_t seed) {
+    long long undirected = (long long)vertices * avgDegree / 2;
+    EdgeList* edges = createEdgeList((int)(undirected * 2));
+    uint64_t state = seed ? seed : 88172645463325252ULL;
+    
+    for (long long i = 0; i < undirected; i++) {
+        // xorshift64
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int a = (int)((state >> 32) % (uint64_t)vertices) + 1;
+        int b = (int)((state & 0xffffffffULL) % (uint64_t)vertices) + 1;
+        if (a == b) continue;
+        addEdge(edges, a, b);
+        addEdge(edges, b, a);
+    }
+    
+    Graph* graph = buildGraph(vertices, edges);
+    freeEdgeList(edges);
+    return graph;
+}
+
+// 그래프 출력 (디버깅용)
+void printGraph(Graph* graph) {
+    for (int i = 1; i <= graph->numVertices; i++) {
+        printf("%d: ", i);
+        for (int e = graph->offsets[i]; e < graph->offsets[i + 1]; e++) {
+            printf("%d ", graph->adj[e]);
+        }
+        printf("\n");
+    }
+}
+
+// BFS로 시작 노드에서 모든 노드까지의 거리 계산
+int* bfs(Graph* graph, int start) {
+    int* dist = (int*)malloc((graph->numVertices + 1) * sizeof(int));
+    int* visited = (int*)malloc((graph->numVertices + 1) * sizeof(int));
+    
+    // 초기화
+    for (int i = 1; i <= graph->numVertices; i++) {
+        dist[i] = INF;
+        visited[i] = 0;
+    }
+    
+    // 각 정점은 한 번만 들어가므로 정점 수 크기의 배열이면 충분
+    int* queue = (int*)malloc((graph->numVertices + 1) * sizeof(int));
+    int front = 0, rear = 0;
+    
+    dist[start] = 0;
+    visited[start] = 1;
+    queue[rear++] = start;
+    
+    while (front < rear) {
+        int current = queue[front++];
+        
+        for (int e = graph->offsets[current]; e < graph->offsets[current + 1]; e++) {
+            int neighbor = graph->adj[e];
+            if (!visited[neighbor]) {
+                visited[neighbor] = 1;
+                dist[neighbor] = dist[current] + 1;
+                queue[rear++] = neighbor;
+            }
+        }
+    }
+    
+    free(visited);
+    free(queue);
+    return dist;
+}
+
+// BFS 작업 공간 (한 스레드가 여러 번의 탐색에 재사용)
+// stamp[v] == epoch 이면 이번 탐색에서 이미 방문한 정점이므로 탐색마다 배열을 비울 필요가 없음
+typedef struct BfsWorkspace {
+    int numVertices;
+    int epoch;
+    int* stamp;
+    int* queue;
+} BfsWorkspace;
+
+BfsWorkspace* createBfsWorkspace(int numVertices) {
+    BfsWorkspace* ws = (BfsWorkspace*)malloc(sizeof(BfsWorkspace));
+    ws->numVertices = numVertices;
+    ws->epoch = 0;
+    ws->stamp = (int*)calloc(numVertices + 1, sizeof(int));
+    ws->queue = (int*)malloc((numVertices + 1) * sizeof(int));
+    return ws;
+}
+
+void freeBfsWorkspace(BfsWorkspace* ws) {
+    free(ws->stamp);
+    free(ws->queue);
+    free(ws);
+}
+
+// 새 탐색을 위한 epoch 증가 (넘치기 직전에만 stamp를 한 번 비움)
+static inline int nextEpoch(BfsWorkspace* ws) {
+    if (ws->epoch == INT_MAX) {
+        memset(ws->stamp, 0, (ws->numVertices + 1) * sizeof(int));
+        ws->epoch = 0;
+    }
+    return ++ws->epoch;
+}
+
+// offsets/adj로 주어진 간선을 따라 start에서 maxDist 단계까지만 탐색
+// 도달한 정점 수를 반환하며, 탐색이 끝나면 ws->queue 앞부분에 그 정점들이 남아 있음
+static int limitedBfs(const int* offsets, const int* adj, BfsWorkspace* ws, int start, int maxDist) {
+    int epoch = nextEpoch(ws);
+    int* stamp = ws->stamp;
+    int* queue = ws->queue;
+    int front = 0, rear = 0;
+    
+    stamp[start] = epoch;
+    queue[rear++] = start;
+    
+    // 한 단계씩 [front, levelEnd) 구간이 현재 프런티어
+    for (int depth = 0; depth < maxDist && front < rear; depth++) {
+        int levelEnd = rear;
+        while (front < levelEnd) {
+            int current = queue[front++];
+            for (int e = offsets[current]; e < offsets[current + 1]; e++) {
+                int neighbor = adj[e];
+                if (stamp[neighbor] != epoch) {
+                    stamp[neighbor] = epoch;
+                    queue[rear++] = neighbor;
+                }
+            }
+        }
+    }
+    
+    return rear;
+}
+
+// start에서 maxDist 단계 이내의 정점 수 (자기 자신 포함), maxDist 단계에서 탐색을 멈춤
+int countWithinDistance(const Graph* graph, BfsWorkspace* ws, int start, int maxDist) {
+    return limitedBfs(graph->offsets, graph->adj, ws, start, maxDist);
+}
+
+// 방향 최적화 BFS의 전환 기준 (Beamer et al.)
+// 프런티어의 간선 수가 남은 간선의 1/ALPHA를 넘으면 상향식, 프런티어가 정점의 1/BETA 밑으로 줄면 하향식
+#define DOBFS_ALPHA 14
+#define DOBFS_BETA 24
+
+// 비트맵 (0 ~ n번 정점)
+#define BITMAP_WORDS(n) (((size_t)(n) >> 6) + 1)
+
+static inline int testBit(const uint64_t* bitmap, int i) {
+    return (int)((bitmap[i >> 6] >> (i & 63)) & 1);
+}
+
+static inline void setBit(uint64_t* bitmap, int i) {
+    bitmap[i >> 6] |= 1ULL << (i & 63);
+}
+
+// 하향식 단계: 프런티어 큐의 이웃 중 미방문 정점을 다음 큐에 넣고, 새 정점들의 차수 합을 반환
+static long long topDownStep(const Graph* graph, const int* frontier, int frontierSize,
+                             int* next, int* nextSize, uint64_t* visited, int* dist) {
+    long long scout = 0;
+    int count = 0;
+    for (int i = 0; i < frontierSize; i++) {
+        int u = frontier[i];
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int v = graph->adj[e];
+            if (!testBit(visited, v)) {
+                setBit(visited, v);
+                dist[v] = dist[u] + 1;
+                next[count++] = v;
+                scout += graph->offsets[v + 1] - graph->offsets[v];
+            }
+        }
+    }
+    *nextSize = count;
+    return scout;
+}
+
+// 상향식 단계: 미방문 정점마다 들어오는 이웃 중 프런티어에 있는 것을 찾으면 방문하고 멈춤
+static int bottomUpStep(const Graph* graph, const uint64_t* frontier, uint64_t* next,
+                        uint64_t* visited, int* dist, int depth) {
+    int n = graph->numVertices;
+    int awake = 0;
+    size_t words = BITMAP_WORDS(n);
+    
+    for (size_t w = 0; w < words; w++) {
+        uint64_t unvisited = ~visited[w];
+        while (unvisited) {
+            int v = (int)(w * 64) + __builtin_ctzll(unvisited);
+            unvisited &= unvisited - 1;
+            if (v < 1 || v > n) continue;
+            
+            for (int e = graph->revOffsets[v]; e < graph->revOffsets[v + 1]; e++) {
+                if (testBit(frontier, graph->revAdj[e])) {
+                    setBit(visited, v);
+                    setBit(next, v);
+                    dist[v] = depth + 1;
+                    awake++;
+                    break;
+                }
+            }
+        }
+    }
+    return awake;
+}
+
+// 방향 최적화 BFS: bfs()와 같은 dist 배열을 반환 (도달 불가는 INF)
+// 상향식 단계에 역방향 CSR이 필요하므로 없으면 그래프에 만들어 둠
+int* bfsDirectionOptimizing(Graph* graph, int start) {
+    int n = graph->numVertices;
+    size_t words = BITMAP_WORDS(n);
+    buildReverseGraph(graph);
+    
+    int* dist = (int*)malloc((n + 1) * sizeof(int));
+    for (int i = 1; i <= n; i++) {
+        dist[i] = INF;
+    }
+    
+    uint64_t* visited = (uint64_t*)calloc(words, sizeof(uint64_t));
+    uint64_t* frontierBits = (uint64_t*)calloc(words, sizeof(uint64_t));
+    uint64_t* nextBits = (uint64_t*)calloc(words, sizeof(uint64_t));
+    int* queue = (int*)malloc((n + 1) * sizeof(int));
+    int* nextQueue = (int*)malloc((n + 1) * sizeof(int));
+    int queueSize = 0;
+    
+    dist[start] = 0;
+    setBit(visited, start);
+    queue[queueSize++] = start;
+    
+    long long edgesToCheck = graph->numEdges;
+    long long scout = graph->offsets[start + 1] - graph->offsets[start];
+    
+    while (queueSize > 0) {
+        if (scout > edgesToCheck / DOBFS_ALPHA) {
+            // 큐 → 비트맵으로 바꾸고 프런티어가 충분히 줄어들 때까지 상향식으로 진행
+            memset(frontierBits, 0, words * sizeof(uint64_t));
+            for (int i = 0; i < queueSize; i++) {
+                setBit(frontierBits, queue[i]);
+            }
+            int depth = dist[queue[0]];
+            int awake = queueSize, oldAwake;
+            do {
+                oldAwake = awake;
+                memset(nextBits, 0, words * sizeof(uint64_t));
+                awake = bottomUpStep(graph, frontierBits, nextBits, visited, dist, depth);
+                uint64_t* tmp = frontierBits;
+                frontierBits = nextBits;
+                nextBits = tmp;
+                depth++;
+            } while (awake >= oldAwake || awake > n / DOBFS_BETA);
+            
+            // 비트맵 → 큐
+            queueSize = 0;
+            for (size_t w = 0; w < words; w++) {
+                uint64_t bits = frontierBits[w];
+                while (bits) {
+                    queue[queueSize++] = (int)(w * 64) + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                }
+            }
+            scout = 1;
+        } else {
+            edgesToCheck -= scout;
+            int nextSize;
+            scout = topDownStep(graph, queue, queueSize, nextQueue, &nextSize, visited, dist);
+            int* tmp = queue;
+            queue = nextQueue;
+            nextQueue = tmp;
+            queueSize = nextSize;
+        }
+    }
+    
+    free(visited);
+    free(frontierBits);
+    free(nextBits);
+    free(queue);
+    free(nextQueue);
+    return dist;
+}
+
+// 현재 시각 (초)
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// bfs와 bfsDirectionOptimizing을 같은 시작 정점들에서 실행해 시간과 결과를 비교
+void benchmarkBfs(Graph* graph, int samples) {
+    int n = graph->numVertices;
+    unsigned int seed = 12345;
+    double plainTime = 0, optimizedTime = 0;
+    int mismatches = 0;
+    
+    buildReverseGraph(graph); // 역방향 CSR 생성 시간은 측정에서 제외
+    
+    for (int s = 0; s < samples; s++) {
+        seed = seed * 1103515245 + 12345;
+        int start = (int)((seed >> 8) % (unsigned)n) + 1;
+        
+        double t0 = nowSeconds();
+        int* expected = bfs(graph, start);
+        double t1 = nowSeconds();
+        int* actual = bfsDirectionOptimizing(graph, start);
+        double t2 = nowSeconds();
+        
+        plainTime += t1 - t0;
+        optimizedTime += t2 - t1;
+        if (memcmp(expected + 1, actual + 1, n * sizeof(int)) != 0) mismatches++;
+        
+        free(expected);
+        free(actual);
+    }
+    
+    printf("[BFS 벤치마크] 정점 %d, 간선 %d, 시작 정점 %d개\n", n, graph->numEdges, samples);
+    printf("  bfs                    : %.3f ms/회\n", plainTime * 1000 / samples);
+    printf("  bfsDirectionOptimizing : %.3f ms/회 (%.2f배)\n",
+           optimizedTime * 1000 / samples, optimizedTime > 0 ? plainTime / optimizedTime : 0);
+    printf("  결과 불일치            : %d회\n", mismatches);
+}
+
+// 양방향 BFS 작업 공간 (앞쪽은 src에서 간선 방향으로, 뒤쪽은 dest에서 간선 반대 방향으로 탐색)
+// stamp가 epoch와 같은 칸만 이번 질의에서 유효하므로 질의마다 배열을 비울 필요가 없음
+typedef struct PairWorkspace {
+    int numVertices;
+    int epoch;
+    int* forwardStamp;
+    int* backwardStamp;
+    int* forwardDist;
+    int* backwardDist;
+    int* forwardParent;  // src 쪽으로 한 칸 앞 정점
+    int* backwardParent; // dest 쪽으로 한 칸 뒤 정점
+    int* forwardQueue;
+    int* backwardQueue;
+} PairWorkspace;
+
+PairWorkspace* createPairWorkspace(int numVertices) {
+    PairWorkspace* ws = (PairWorkspace*)malloc(sizeof(PairWorkspace));
+    size_t size = ((size_t)numVertices + 1) * sizeof(int);
+    ws->numVertices = numVertices;
+    ws->epoch = 0;
+    ws->forwardStamp = (int*)calloc(numVertices + 1, sizeof(int));
+    ws->backwardStamp = (int*)calloc(numVertices + 1, sizeof(int));
+    ws->forwardDist = (int*)malloc(size);
+    ws->backwardDist = (int*)malloc(size);
+    ws->forwardParent = (int*)malloc(size);
+    ws->backwardParent = (int*)malloc(size);
+    ws->forwardQueue = (int*)malloc(size);
+    ws->backwardQueue = (int*)malloc(size);
+    return ws;
+}
+
+void freePairWorkspace(PairWorkspace* ws) {
+    free(ws->forwardStamp);
+    free(ws->backwardStamp);
+    free(ws->forwardDist);
+    free(ws->backwardDist);
+    free(ws->forwardParent);
+    free(ws->backwardParent);
+    free(ws->forwardQueue);
+    free(ws->backwardQueue);
+    free(ws);
+}
+
+// 한쪽 프런티어 한 단계를 전부 펼침 (offsets/adj는 그쪽 탐색 방향의 CSR)
+// 새로 방문한 정점이 반대쪽에서 이미 방문된 정점이면 만난 것이므로 가장 짧은 합을 *best에 기록
+static void expandLevel(const int* offsets, const int* adj, int epoch,
+                        int* stamp, int* dist, int* parent, int* queue, int* front, int* rear,
+                        const int* otherStamp, const int* otherDist,
+                        int* best, int* meetNear, int* meetFar) {
+    int levelEnd = *rear;
+    while (*front < levelEnd) {
+        int current = queue[(*front)++];
+        for (int e = offsets[current]; e < offsets[current + 1]; e++) {
+            int neighbor = adj[e];
+            if (stamp[neighbor] == epoch) continue;
+            stamp[neighbor] = epoch;
+            dist[neighbor] = dist[current] + 1;
+            parent[neighbor] = current;
+            queue[(*rear)++] = neighbor;
+            
+            if (otherStamp[neighbor] == epoch && dist[neighbor] + otherDist[neighbor] < *best) {
+                *best = dist[neighbor] + otherDist[neighbor];
+                *meetNear = current;
+                *meetFar = neighbor;
+            }
+        }
+    }
+}
+
+// 양방향 BFS로 src에서 dest까지의 최단 거리 (도달 불가면 -1)
+// 매 단계 프런티어가 작은 쪽을 한 단계 펼치고, 두 탐색이 만난 단계가 끝나면 멈춤
+// path가 NULL이 아니면 src부터 dest까지의 정점을 채우고 정점 수를 *pathLength에 저장 (거리 + 1칸 필요)
+int bidirectionalDistance(Graph* graph, PairWorkspace* ws, int src, int dest, int* path, int* pathLength) {
+    int n = graph->numVertices;
+    if (pathLength) *pathLength = 0;
+    if (src < 1 || src > n || dest < 1 || dest > n) return -1;
+    if (src == dest) {
+        if (path) path[0] = src;
+        if (pathLength) *pathLength = 1;
+        return 0;
+    }
+    buildReverseGraph(graph);
+    
+    if (ws->epoch == INT_MAX) {
+        memset(ws->forwardStamp, 0, (n + 1) * sizeof(int));
+        memset(ws->backwardStamp, 0, (n + 1) * sizeof(int));
+        ws->epoch = 0;
+    }
+    int epoch = ++ws->epoch;
+    
+    int forwardFront = 0, forwardRear = 0, backwardFront = 0, backwardRear = 0;
+    ws->forwardStamp[src] = epoch;
+    ws->forwardDist[src] = 0;
+    ws->forwardQueue[forwardRear++] = src;
+    ws->backwardStamp[dest] = epoch;
+    ws->backwardDist[dest] = 0;
+    ws->backwardQueue[backwardRear++] = dest;
+    
+    int best = INF, forwardMeet = -1, backwardMeet = -1;
+    while (best == INF && forwardFront < forwardRear && backwardFront < backwardRear) {
+        if (forwardRear - forwardFront <= backwardRear - backwardFront) {
+            expandLevel(graph->offsets, graph->adj, epoch,
+                        ws->forwardStamp, ws->forwardDist, ws->forwardParent,
+                        ws->forwardQueue, &forwardFront, &forwardRear,
+                        ws->backwardStamp, ws->backwardDist, &best, &forwardMeet, &backwardMeet);
+        } else {
+            expandLevel(graph->revOffsets, graph->revAdj, epoch,
+                        ws->backwardStamp, ws->backwardDist, ws->backwardParent,
+                        ws->backwardQueue, &backwardFront, &backwardRear,
+                        ws->forwardStamp, ws->forwardDist, &best, &backwardMeet, &forwardMeet);
+        }
+    }
+    if (best == INF) return -1;
+    
+    if (path) {
+        // 만난 간선 forwardMeet → backwardMeet을 기준으로 앞쪽은 거꾸로, 뒤쪽은 그대로 따라감
+        int length = ws->forwardDist[forwardMeet] + 1;
+        int v = forwardMeet;
+        for (int i = length - 1; i >= 0; i--) {
+            path[i] = v;
+            v = ws->forwardParent[v];
+        }
+        for (v = backwardMeet; ; v = ws->backwardParent[v]) {
+            path[length++] = v;
+            if (v == dest) break;
+        }
+        if (pathLength) *pathLength = length;
+    }
+    return best;
+}
+
+// 두 노드 간의 최단 거리 계산
+int getDistance(Graph* graph, int src, int dest) {
+    PairWorkspace* ws = createPairWorkspace(graph->numVertices);
+    int result = bidirectionalDistance(graph, ws, src, dest, NULL, NULL);
+    freePairWorkspace(ws);
+    return result;
+}
+
+// (1) 나와 너의 거리는? - 67번과 26번 사이의 거리
+void question1(Graph* graph) {
+    PairWorkspace* ws = createPairWorkspace(graph->numVertices);
+    int* path = (int*)malloc((graph->numVertices + 1) * sizeof(int));
+    int pathLength = 0;
+    int dist = bidirectionalDistance(graph, ws, 67, 26, path, &pathLength);
+    
+    printf("(1) 67번과 26번 사이의 거리: %d\n", dist);
+    if (pathLength > 0) {
+        printf("    경로: ");
+        for (int i = 0; i < pathLength; i++) {
+            printf(i == 0 ? "%d" : " -> %d", path[i]);
+        }
+        printf("\n");
+    }
+    
+    free(path);
+    freePairWorkspace(ws);
+}
+
+// 무작위 정점 쌍에 대해 bfs 기반 거리와 양방향 BFS 거리/경로를 비교
+void benchmarkDistance(Graph* graph, int samples) {
+    int n = graph->numVertices;
+    unsigned int seed = 777;
+    int* path = (int*)malloc((n + 1) * sizeof(int));
+    PairWorkspace* ws = createPairWorkspace(n);
+    double plainTime = 0, pairTime = 0;
+    int mismatches = 0;
+    
+    buildReverseGraph(graph);
+    
+    for (int s = 0; s < samples; s++) {
+        seed = seed * 1103515245 + 12345;
+        int src = (int)((seed >> 8) % (unsigned)n) + 1;
+        seed = seed * 1103515245 + 12345;
+        int dest = (int)((seed >> 8) % (unsigned)n) + 1;
+        
+        double t0 = nowSeconds();
+        int* dist = bfs(graph, src);
+        int expected = dist[dest] == INF ? -1 : dist[dest];
+        double t1 = nowSeconds();
+        int pathLength;
+        int actual = bidirectionalDistance(graph, ws, src, dest, path, &pathLength);
+        double t2 = nowSeconds();
+        free(dist);
+        plainTime += t1 - t0;
+        pairTime += t2 - t1;
+        
+        // 경로가 실제 간선으로 이어지고 길이가 거리와 같은지 확인
+        int valid = actual == expected;
+        if (valid && actual >= 0) {
+            valid = pathLength == actual + 1 && path[0] == src && path[pathLength - 1] == dest;
+            for (int i = 0; valid && i + 1 < pathLength; i++) {
+                int found = 0;
+                for (int e = graph->offsets[path[i]]; e < graph->offsets[path[i] + 1]; e++) {
+                    if (graph->adj[e] == path[i + 1]) {
+                        found = 1;
+                        break;
+                    }
+                }
+                valid = found;
+            }
+        }
+        if (!valid) mismatches++;
+    }
+    
+    printf("[두 정점 거리 벤치마크] 정점 쌍 %d개\n", samples);
+    printf("  bfs                    : %.3f ms/회\n", plainTime * 1000 / samples);
+    printf("  bidirectionalDistance  : %.3f ms/회 (%.2f배, 경로 포함)\n",
+           pairTime * 1000 / samples, pairTime > 0 ? plainTime / pairTime : 0);
+    printf("  결과 불일치            : %d회\n", mismatches);
+    
+    freePairWorkspace(ws);
+    free(path);
+}
+
+// 사용할 스레드 수 (0 이하이면 CPU 코어 수)
+int resolveThreadCount(int numThreads) {
+    if (numThreads > 0) return numThreads;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+// numThreads개의 스레드에서 worker(arg)를 실행하고 모두 끝날 때까지 기다림
+// worker는 공유 카운터에서 일을 가져가므로 스레드를 만들 수 없으면 현재 스레드가 전부 처리
+void runWorkers(void* (*worker)(void*), void* arg, int numThreads) {
+    numThreads = resolveThreadCount(numThreads);
+    pthread_t* threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+    int started = 0;
+    for (int t = 0; t < numThreads; t++) {
+        if (pthread_create(&threads[t], NULL, worker, arg) != 0) break;
+        started++;
+    }
+    if (started == 0) worker(arg);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
+
+// (2) Lone Wolf는? - 연결된 컴포넌트 (간선 방향은 무시한 약연결 컴포넌트)
+typedef struct Components {
+    int count;
+    int* id;   // id[v]: v가 속한 컴포넌트 번호 (1..count, 가장 작은 정점 번호 순)
+    int* size; // size[c]: 컴포넌트 c의 정점 수
+} Components;
+
+void freeComponents(Components* components) {
+    free(components->id);
+    free(components->size);
+    free(components);
+}
+
+// Afforest 방식 병렬 유니온 파인드
+// 1) 정점마다 처음 AFFOREST_ROUNDS개의 이웃만 먼저 합치고 경로를 압축하면 대부분의 정점이
+//    가장 큰 컴포넌트에 들어감 2) 표본으로 그 컴포넌트를 찾아 3) 거기 속하지 않은 정점의
+//    나머지 간선만 합침. 큰 컴포넌트 안의 간선 대부분을 건너뛸 수 있음
+#define AFFOREST_ROUNDS 2
+#define AFFOREST_SAMPLES 1024
+#define COMPONENT_CHUNK 4096
+
+enum { LINK_SAMPLE, COMPRESS, LINK_REMAINING };
+
+typedef struct ComponentJob {
+    const Graph* graph;
+    int* parent;
+    int phase;
+    int round;      // LINK_SAMPLE에서 합칠 이웃 순번
+    int skipRoot;   // LINK_REMAINING에서 건너뛸 가장 큰 컴포넌트의 루트
+    int nextVertex; // 다음에 가져갈 정점 (원자적으로 증가)
+} ComponentJob;
+
+static void* componentWorker(void* arg) {
+    ComponentJob* job = (ComponentJob*)arg;
+    const Graph* graph = job->graph;
+    int n = graph->numVertices;
+    int* parent = job->parent;
+    
+    while (1) {
+        int begin = __atomic_fetch_add(&job->nextVertex, COMPONENT_CHUNK, __ATOMIC_RELAXED);
+        if (begin > n) break;
+        int end = begin + COMPONENT_CHUNK - 1 < n ? begin + COMPONENT_CHUNK - 1 : n;
+        for (int v = begin; v <= end; v++) {
+            if (job->phase == LINK_SAMPLE) {
+                int e = graph->offsets[v] + job->round;
+                if (e < graph->offsets[v + 1]) uniteVertices(parent, v, graph->adj[e]);
+            } else if (job->phase == COMPRESS) {
+                __atomic_store_n(&parent[v], findRoot(parent, v), __ATOMIC_RELAXED);
+            } else if (findRoot(parent, v) != job->skipRoot) {
+                // 큰 컴포넌트의 정점에서 나가는 간선은 건너뛰므로 들어오는 간선도 합쳐야
+                // 방향 그래프에서 빠지는 간선이 없음
+                for (int e = graph->offsets[v] + AFFOREST_ROUNDS; e < graph->offsets[v + 1]; e++) {
+                    uniteVertices(parent, v, graph->adj[e]);
+                }
+                for (int e = graph->revOffsets[v]; e < graph->revOffsets[v + 1]; e++) {
+                    uniteVertices(parent, v, graph->revAdj[e]);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static void runComponentPhase(ComponentJob* job, int phase, int numThreads) {
+    job->phase = phase;
+    job->nextVertex = 1;
+    runWorkers(componentWorker, job, numThreads);
+}
+
+// 병렬 유니온 파인드로 부모 배열을 만듦 (parent[v]가 v의 루트로 압축된 상태, 호출자가 해제)
+int* parallelUnionFind(Graph* graph, int numThreads) {
+    int n = graph->numVertices;
+    ComponentJob job;
+    job.graph = graph;
+    job.parent = (int*)malloc((n + 1) * sizeof(int));
+    for (int v = 0; v <= n; v++) {
+        job.parent[v] = v;
+    }
+    buildReverseGraph(graph);
+    
+    for (job.round = 0; job.round < AFFOREST_ROUNDS; job.round++) {
+        runComponentPhase(&job, LINK_SAMPLE, numThreads);
+    }
+    runComponentPhase(&job, COMPRESS, numThreads);
+    
+    // 무작위 표본에서 가장 자주 나온 루트를 가장 큰 컴포넌트로 봄
+    int* roots = (int*)malloc(AFFOREST_SAMPLES * sizeof(int));
+    unsigned int seed = 2024;
+    for (int i = 0; i < AFFOREST_SAMPLES; i++) {
+        seed = seed * 1103515245 + 12345;
+        roots[i] = job.parent[(int)((seed >> 8) % (unsigned)n) + 1];
+    }
+    job.skipRoot = roots[0];
+    int bestCount = 0;
+    for (int i = 0; i < AFFOREST_SAMPLES; i++) {
+        int count = 0;
+        for (int j = 0; j < AFFOREST_SAMPLES; j++) {
+            count += roots[j] == roots[i];
+        }
+        if (count > bestCount) {
+            bestCount = count;
+            job.skipRoot = roots[i];
+        }
+    }
+    free(roots);
+    
+    runComponentPhase(&job, LINK_REMAINING, numThreads);
+    runComponentPhase(&job, COMPRESS, numThreads);
+    return job.parent;
+}
+
+// 유니온 파인드 부모 배열에서 컴포넌트 번호와 크기를 만듦
+// 루트는 컴포넌트의 가장 작은 정점이므로 정점 순서대로 훑으면 루트가 먼저 번호를 받음
+static Components* labelComponents(int* parent, int n) {
+    Components* components = (Components*)malloc(sizeof(Components));
+    components->id = (int*)malloc((n + 1) * sizeof(int));
+    components->count = 0;
+    components->id[0] = 0;
+    for (int v = 1; v <= n; v++) {
+        int root = findRoot(parent, v);
+        components->id[v] = root == v ? ++components->count : components->id[root];
+    }
+    
+    components->size = (int*)calloc(components->count + 1, sizeof(int));
+    for (int v = 1; v <= n; v++) {
+        components->size[components->id[v]]++;
+    }
+    return components;
+}
+
+// 연결 컴포넌트 계산 (호출자가 freeComponents로 해제)
+// 텍스트에서 읽은 그래프는 읽으면서 합쳐 둔 결과를 쓰고, 스냅샷/생성 그래프는 병렬로 계산해 보관
+Components* findComponents(Graph* graph, int numThreads) {
+    if (!graph->componentParent) graph->componentParent = parallelUnionFind(graph, numThreads);
+    return labelComponents(graph->componentParent, graph->numVertices);
+}
+
+int countComponents(Graph* graph) {
+    Components* components = findComponents(graph, 0);
+    int count = components->count;
+    freeComponents(components);
+    return count;
+}
+
+void question2(Graph* graph, int numThreads) {
+    Components* components = findComponents(graph, numThreads);
+    int largest = 0, alone = 0;
+    for (int c = 1; c <= components->count; c++) {
+        if (components->size[c] > largest) largest = components->size[c];
+        if (components->size[c] == 1) alone++;
+    }
+    
+    printf("(2) 연결된 컴포넌트 수 (Lone Wolf): %d\n", components->count);
+    printf("    가장 큰 컴포넌트: %d명, 혼자인 사람: %d명\n", largest, alone);
+    freeComponents(components);
+}
+
+// 읽으면서 계산한 유니온 파인드, 간선 전체를 순서대로 합치는 유니온 파인드, 병렬 Afforest 비교
+void benchmarkComponents(Graph* graph, int numThreads) {
+    int n = graph->numVertices;
+    
+    double t0 = nowSeconds();
+    int* sequential = (int*)malloc((n + 1) * sizeof(int));
+    for (int v = 0; v <= n; v++) {
+        sequential[v] = v;
+    }
+    for (int v = 1; v <= n; v++) {
+        for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+            uniteVertices(sequential, v, graph->adj[e]);
+        }
+    }
+    Components* expected = labelComponents(sequential, n);
+    double sequentialTime = nowSeconds() - t0;
+    
+    buildReverseGraph(graph);
+    t0 = nowSeconds();
+    int* parallel = parallelUnionFind(graph, numThreads);
+    Components* actual = labelComponents(parallel, n);
+    double parallelTime = nowSeconds() - t0;
+    
+    int same = expected->count == actual->count &&
+               memcmp(expected->id, actual->id, (n + 1) * sizeof(int)) == 0;
+    printf("[연결 컴포넌트 벤치마크] 정점 %d, 컴포넌트 %d개\n", n, expected->count);
+    printf("  순차 유니온 파인드     : %.3f ms\n", sequentialTime * 1000);
+    printf("  병렬 Afforest          : %.3f ms (%.2f배, 스레드 %d, %s)\n",
+           parallelTime * 1000, parallelTime > 0 ? sequentialTime / parallelTime : 0,
+           resolveThreadCount(numThreads), same ? "결과 일치" : "결과 불일치");
+    if (graph->componentParent) {
+        Components* loaded = labelComponents(graph->componentParent, n);
+        int loadedSame = loaded->count == expected->count &&
+                         memcmp(loaded->id, expected->id, (n + 1) * sizeof(int)) == 0;
+        printf("  읽을 때 계산한 결과    : %s\n", loadedSame ? "결과 일치" : "결과 불일치");
+        freeComponents(loaded);
+    }
+    
+    freeComponents(expected);
+    freeComponents(actual);
+    free(sequential);
+    free(parallel);
+}
+
+// (3) 3단계 이내에 가장 많은 사람에게 도달할 수 있는 사람
+int countReachable(Graph* graph, int start, int maxDist) {
+    BfsWorkspace* ws = createBfsWorkspace(graph->numVertices);
+    int count = countWithinDistance(graph, ws, start, maxDist);
+    freeBfsWorkspace(ws);
+    return count;
+}
+
+// 모든 정점의 도달 수 계산을 스레드에 나눠주기 위한 공유 상태
+#define REACH_CHUNK 64
+
+typedef struct ReachJob {
+    const Graph* graph;
+    int maxDist;
+    int* counts;
+    int nextVertex; // 다음에 가져갈 정점 (원자적으로 증가)
+} ReachJob;
+
+static void* reachWorker(void* arg) {
+    ReachJob* job = (ReachJob*)arg;
+    int n = job->graph->numVertices;
+    BfsWorkspace* ws = createBfsWorkspace(n);
+    
+    while (1) {
+        int begin = __atomic_fetch_add(&job->nextVertex, REACH_CHUNK, __ATOMIC_RELAXED);
+        if (begin > n) break;
+        int end = begin + REACH_CHUNK - 1 < n ? begin + REACH_CHUNK - 1 : n;
+        for (int v = begin; v <= end; v++) {
+            job->counts[v] = countWithinDistance(job->graph, ws, v, job->maxDist);
+        }
+    }
+    
+    freeBfsWorkspace(ws);
+    return NULL;
+}
+
+// 모든 정점에 대해 maxDist 단계 이내 도달 수를 병렬로 계산 (counts[1..n], 호출자가 해제)
+int* countReachableAll(const Graph* graph, int maxDist, int numThreads) {
+    ReachJob job;
+    job.graph = graph;
+    job.maxDist = maxDist;
+    job.counts = (int*)calloc(graph->numVertices + 1, sizeof(int));
+    job.nextVertex = 1;
+    
+    runWorkers(reachWorker, &job, numThreads);
+    
+    return job.counts;
+}
+
+// 거리 질의 모드: 한 줄에 "src dest" 하나씩 읽어 묶음 단위로 여러 스레드에서 답함
+#define QUERY_BATCH 4096
+#define QUERY_CHUNK 16
+#define QUERY_BUFFER (1 << 16)
+
+typedef struct DistanceQuery {
+    long long src;
+    long long dest;
+    int dist;
+} DistanceQuery;
+
+// 파일 디스크립터에서 직접 읽는 줄 버퍼
+// 버퍼에 남은 완전한 줄이 없으면 이미 모은 질의부터 돌려주므로 파이프 입력도 기다리지 않고 답함
+typedef struct QueryReader {
+    int fd;
+    int eof;
+    int discarding; // 버퍼보다 긴 줄의 나머지를 버리는 중
+    size_t start;
+    size_t end;
+    char buffer[QUERY_BUFFER];
+} QueryReader;
+
+// 한 줄에서 정수 두 개를 읽음 (빈 줄, '#' 주석, 정수가 하나뿐인 줄은 0)
+static int parseQueryLine(const char* p, const char* end, DistanceQuery* query) {
+    while (p < end && isBlank(*p)) p++;
+    if (p == end || *p == '#') return 0;
+    p = parseToken(p, end, &query->src);
+    while (p < end && isBlank(*p)) p++;
+    if (p == end) return 0;
+    parseToken(p, end, &query->dest);
+    return 1;
+}
+
+// 질의를 최대 maxCount개 읽음 (0이면 입력 끝)
+static int readQueryBatch(QueryReader* reader, DistanceQuery* queries, int maxCount) {
+    int count = 0;
+    while (count < maxCount) {
+        char* line = reader->buffer + reader->start;
+        char* lineEnd = (char*)memchr(line, '\n', reader->end - reader->start);
+        size_t consumed;
+        
+        if (lineEnd) {
+            consumed = lineEnd - line + 1;
+        } else if (reader->eof) {
+            if (reader->start == reader->end) break;
+            lineEnd = reader->buffer + reader->end; // 개행 없는 마지막 줄
+            consumed = lineEnd - line;
+        } else if (count > 0) {
+            break;
+        } else {
+            // 남은 조각을 앞으로 당기고 더 읽음 (버퍼를 가득 채운 줄은 잘라서 처리)
+            if (reader->start == 0 && reader->end == QUERY_BUFFER) {
+                lineEnd = reader->buffer + reader->end;
+                consumed = reader->end;
+            } else {
+                memmove(reader->buffer, line, reader->end - reader->start);
+                reader->end -= reader->start;
+                reader->start = 0;
+                ssize_t got = read(reader->fd, reader->buffer + reader->end, QUERY_BUFFER - reader->end);
+                if (got < 0 && errno == EINTR) continue;
+                if (got <= 0) {
+                    reader->eof = 1;
+                } else {
+                    reader->end += got;
+                }
+                continue;
+            }
+        }
+        
+        reader->start += consumed;
+        int truncated = lineEnd == reader->buffer + QUERY_BUFFER && !reader->eof;
+        if (reader->discarding) {
+            reader->discarding = truncated;
+            continue;
+        }
+        if (parseQueryLine(line, lineEnd, &queries[count])) count++;
+        reader->discarding = truncated;
+    }
+    return count;
+}
+
+// 묶음 하나를 나눠 처리하기 위한 공유 상태
+// 작업 공간은 스레드 번호별로 한 번만 만들어 이후 묶음에서도 그대로 재사용
+typedef struct QueryJob {
+    Graph* graph;
+    DistanceQuery* queries;
+    int count;
+    int nextQuery;     // 다음에 가져갈 질의 (원자적으로 증가)
+    int nextWorkspace; // 다음 스레드가 쓸 작업 공간 번호
+    int numWorkspaces;
+    PairWorkspace** workspaces;
+} QueryJob;
+
+static void* queryWorker(void* arg) {
+    QueryJob* job = (QueryJob*)arg;
+    int slot = __atomic_fetch_add(&job->nextWorkspace, 1, __ATOMIC_RELAXED);
+    if (slot >= job->numWorkspaces) return NULL;
+    if (!job->workspaces[slot]) job->workspaces[slot] = createPairWorkspace(job->graph->numVertices);
+    PairWorkspace* ws = job->workspaces[slot];
+    int n = job->graph->numVertices;
+    
+    while (1) {
+        int begin = __atomic_fetch_add(&job->nextQuery, QUERY_CHUNK, __ATOMIC_RELAXED);
+        if (begin >= job->count) break;
+        int end = begin + QUERY_CHUNK < job->count ? begin + QUERY_CHUNK : job->count;
+        for (int i = begin; i < end; i++) {
+            DistanceQuery* query = &job->queries[i];
+            if (query->src < 1 || query->src > n || query->dest < 1 || query->dest > n) {
+                query->dist = -1;
+            } else {
+                query->dist = bidirectionalDistance(job->graph, ws, (int)query->src, (int)query->dest,
+                                                    NULL, NULL);
+            }
+        }
+    }
+    return NULL;
+}
+
+// 정수를 10진수로 붙이고 다음 쓸 위치를 반환
+static char* appendInteger(char* out, long long value) {
+    char digits[24];
+    int length = 0;
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[length++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0) *out++ = '-';
+    while (length > 0) *out++ = digits[--length];
+    return out;
+}
+
+// input에서 질의를 끝까지 읽어 "src dest 거리"를 입력 순서대로 output에 씀 (도달 불가면 -1)
+// 처리한 질의 수를 반환
+long long answerDistanceQueries(Graph* graph, int inputFd, FILE* output, int numThreads) {
+    numThreads = resolveThreadCount(numThreads);
+    QueryReader* reader = (QueryReader*)malloc(sizeof(QueryReader));
+    reader->fd = inputFd;
+    reader->eof = 0;
+    reader->discarding = 0;
+    reader->start = reader->end = 0;
+    
+    QueryJob job;
+    job.graph = graph;
+    job.queries = (DistanceQuery*)malloc(QUERY_BATCH * sizeof(DistanceQuery));
+    job.numWorkspaces = numThreads;
+    job.workspaces = (PairWorkspace**)calloc(numThreads, sizeof(PairWorkspace*));
+    char* text = (char*)malloc((size_t)QUERY_BATCH * 3 * 24);
+    long long answered = 0;
+    
+    // 역방향 CSR은 스레드들이 공유하므로 미리 만들어 둠
+    buildReverseGraph(graph);
+    
+    while ((job.count = readQueryBatch(reader, job.queries, QUERY_BATCH)) > 0) {
+        job.nextQuery = 0;
+        job.nextWorkspace = 0;
+        // 작은 묶음은 스레드를 띄우는 비용이 더 크므로 현재 스레드에서 처리
+        if (job.count <= QUERY_CHUNK * 2 || numThreads == 1) {
+            queryWorker(&job);
+        } else {
+            runWorkers(queryWorker, &job, numThreads);
+        }
+        
+        char* out = text;
+        for (int i = 0; i < job.count; i++) {
+            out = appendInteger(out, job.queries[i].src);
+            *out++ = ' ';
+            out = appendInteger(out, job.queries[i].dest);
+            *out++ = ' ';
+            out = appendInteger(out, job.queries[i].dist);
+            *out++ = '\n';
+        }
+        fwrite(text, 1, out - text, output);
+        fflush(output);
+        answered += job.count;
+    }
+    
+    for (int t = 0; t < numThreads; t++) {
+        if (job.workspaces[t]) freePairWorkspace(job.workspaces[t]);
+    }
+    free(job.workspaces);
+    free(job.queries);
+    free(text);
+    free(reader);
+    return answered;
+}
+
+// 비트 병렬 다중 출발점 BFS (MS-BFS)
+// 정점마다 출발점 하나당 한 비트를 두어 한 번의 간선 순회로 MSBFS_LANES개의 BFS를 함께 진행
+// MSBFS_WORDS를 4로 늘리면 256개씩 진행하며 -mavx2 빌드에서 워드 반복문이 256비트 연산이 됨
+// (희소 그래프에서는 64개씩이 더 빨랐으므로 기본값은 1)
+#define MSBFS_WORDS 1
+#define MSBFS_LANES (MSBFS_WORDS * 64)
+
+// 프런티어의 간선 수가 전체 간선의 1/MSBFS_PULL_DIVISOR를 넘으면 상향식으로 진행
+#define MSBFS_PULL_DIVISOR 4
+
+typedef struct MsBfsWorkspace {
+    uint64_t* seen;     // seen[v * MSBFS_WORDS + w]: v에 이미 도달한 출발점 비트
+    uint64_t* frontier; // 직전 단계에 v에 처음 도달한 출발점 비트
+    uint64_t* next;     // 이번 단계에 v에 처음 도달하는 출발점 비트
+    int* frontierList;  // frontier가 0이 아닌 정점 목록
+    int* nextList;
+    int* touched;       // seen이 0이 아닌 정점 목록 (배치가 끝나면 이 정점들만 비움)
+} MsBfsWorkspace;
+
+MsBfsWorkspace* createMsBfsWorkspace(int numVertices) {
+    size_t words = ((size_t)numVertices + 1) * MSBFS_WORDS;
+    MsBfsWorkspace* ws = (MsBfsWorkspace*)malloc(sizeof(MsBfsWorkspace));
+    ws->seen = (uint64_t*)calloc(words, sizeof(uint64_t));
+    ws->frontier = (uint64_t*)calloc(words, sizeof(uint64_t));
+    ws->next = (uint64_t*)calloc(words, sizeof(uint64_t));
+    ws->frontierList = (int*)malloc((numVertices + 1) * sizeof(int));
+    ws->nextList = (int*)malloc((numVertices + 1) * sizeof(int));
+    ws->touched = (int*)malloc((numVertices + 1) * sizeof(int));
+    return ws;
+}
+
+void freeMsBfsWorkspace(MsBfsWorkspace* ws) {
+    free(ws->seen);
+    free(ws->frontier);
+    free(ws->next);
+    free(ws->frontierList);
+    free(ws->nextList);
+    free(ws->touched);
+    free(ws);
+}
+
+// sources[0..numSources) (최대 MSBFS_LANES개, 서로 다른 정점)에서 동시에 maxDist 단계까지 탐색
+// counts[lane]에 sources[lane]에서 도달한 정점 수를 저장 (countMask가 있으면 countMask[v] != 0인 정점만 셈)
+// 프런티어가 커지면 상향식으로 바꾸므로 역방향 CSR이 미리 만들어져 있어야 함
+static void msbfsBatch(const Graph* graph, MsBfsWorkspace* ws, const int* sources, int numSources,
+                       int maxDist, const unsigned char* countMask, int* counts) {
+    uint64_t* seen = ws->seen;
+    uint64_t* frontier = ws->frontier;
+    uint64_t* next = ws->next;
+    int* frontierList = ws->frontierList;
+    int* nextList = ws->nextList;
+    int frontierSize = 0, touchedSize = 0;
+    uint64_t slices[MSBFS_WORDS][32];
+    memset(slices, 0, sizeof(slices));
+    
+    for (int lane = 0; lane < numSources; lane++) {
+        int v = sources[lane];
+        uint64_t bit = 1ULL << (lane & 63);
+        frontierList[frontierSize++] = v;
+        ws->touched[touchedSize++] = v;
+        frontier[(size_t)v * MSBFS_WORDS + (lane >> 6)] |= bit;
+        seen[(size_t)v * MSBFS_WORDS + (lane >> 6)] |= bit;
+        counts[lane] = (!countMask || countMask[v]) ? 1 : 0;
+    }
+    
+    // 이번 배치에 쓰인 레인 비트 (모두 켜진 정점은 더 볼 필요가 없음)
+    uint64_t lanes[MSBFS_WORDS];
+    for (int w = 0; w < MSBFS_WORDS; w++) {
+        int bits = numSources - w * 64;
+        lanes[w] = bits >= 64 ? ~0ULL : (bits > 0 ? (1ULL << bits) - 1 : 0);
+    }
+    long long frontierEdges = 0;
+    for (int i = 0; i < frontierSize; i++) {
+        frontierEdges += graph->offsets[frontierList[i] + 1] - graph->offsets[frontierList[i]];
+    }
+    
+    for (int depth = 0; depth < maxDist && frontierSize > 0; depth++) {
+        int nextSize = 0;
+        
+        if (frontierEdges > graph->numEdges / MSBFS_PULL_DIVISOR) {
+            // 프런티어가 크면 상향식: 아직 모든 레인이 닿지 않은 정점이 들어오는 이웃의 비트를 모음
+            for (int v = 1; v <= graph->numVertices; v++) {
+                const uint64_t* sv = &seen[(size_t)v * MSBFS_WORDS];
+                uint64_t missing[MSBFS_WORDS], acc[MSBFS_WORDS];
+                uint64_t anyMissing = 0;
+                for (int w = 0; w < MSBFS_WORDS; w++) {
+                    missing[w] = lanes[w] & ~sv[w];
+                    acc[w] = 0;
+                    anyMissing |= missing[w];
+                }
+                if (!anyMissing) continue;
+                
+                for (int e = graph->revOffsets[v]; e < graph->revOffsets[v + 1]; e++) {
+                    const uint64_t* fu = &frontier[(size_t)graph->revAdj[e] * MSBFS_WORDS];
+                    uint64_t remaining = 0;
+                    for (int w = 0; w < MSBFS_WORDS; w++) {
+                        acc[w] |= fu[w] & missing[w];
+                        remaining |= missing[w] & ~acc[w];
+                    }
+                    if (!remaining) break;
+                }
+                
+                uint64_t added = 0;
+                uint64_t* nv = &next[(size_t)v * MSBFS_WORDS];
+                for (int w = 0; w < MSBFS_WORDS; w++) {
+                    nv[w] = acc[w];
+                    added |= acc[w];
+                }
+                if (added) nextList[nextSize++] = v;
+            }
+        } else {
+            // 프런티어 정점의 비트를 이웃에게 밀어 넣음 (이미 본 출발점 비트는 제외)
+            for (int i = 0; i < frontierSize; i++) {
+                int u = frontierList[i];
+                const uint64_t* fu = &frontier[(size_t)u * MSBFS_WORDS];
+                for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+                    int v = graph->adj[e];
+                    const uint64_t* sv = &seen[(size_t)v * MSBFS_WORDS];
+                    uint64_t* nv = &next[(size_t)v * MSBFS_WORDS];
+                    uint64_t added = 0, before = 0;
+                    for (int w = 0; w < MSBFS_WORDS; w++) {
+                        uint64_t bits = fu[w] & ~sv[w];
+                        before |= nv[w];
+                        nv[w] |= bits;
+                        added |= bits;
+                    }
+                    if (added && !before) nextList[nextSize++] = v;
+                }
+            }
+        }
+        
+        for (int i = 0; i < frontierSize; i++) {
+            memset(&frontier[(size_t)frontierList[i] * MSBFS_WORDS], 0, MSBFS_WORDS * sizeof(uint64_t));
+        }
+        
+        // 새로 도달한 비트를 seen에 반영하고 출발점별로 셈
+        frontierEdges = 0;
+        for (int i = 0; i < nextSize; i++) {
+            int v = nextList[i];
+            uint64_t* sv = &seen[(size_t)v * MSBFS_WORDS];
+            const uint64_t* nv = &next[(size_t)v * MSBFS_WORDS];
+            uint64_t before = 0;
+            for (int w = 0; w < MSBFS_WORDS; w++) {
+                before |= sv[w];
+                sv[w] |= nv[w];
+            }
+            if (!before) ws->touched[touchedSize++] = v;
+            frontierEdges += graph->offsets[v + 1] - graph->offsets[v];
+            
+            if (countMask && !countMask[v]) continue;
+            for (int w = 0; w < MSBFS_WORDS; w++) {
+                // 비트 슬라이스 카운터에 더하기: slice[bit]의 lane 비트가 해당 출발점 개수의 2^bit 자리
+                uint64_t carry = nv[w];
+                for (int bit = 0; carry; bit++) {
+                    uint64_t overflow = slices[w][bit] & carry;
+                    slices[w][bit] ^= carry;
+                    carry = overflow;
+                }
+            }
+        }
+        
+        // next가 새 frontier가 됨
+        uint64_t* tmpBits = frontier;
+        frontier = next;
+        next = tmpBits;
+        int* tmpList = frontierList;
+        frontierList = nextList;
+        nextList = tmpList;
+        frontierSize = nextSize;
+    }
+    
+    for (int lane = 0; lane < numSources; lane++) {
+        for (int i = 0; i < 32; i++) {
+            counts[lane] += (int)((slices[lane >> 6][i] >> (lane & 63)) & 1) << i;
+        }
+    }
+    
+    // 다음 배치를 위해 사용한 칸만 비움
+    for (int i = 0; i < frontierSize; i++) {
+        memset(&frontier[(size_t)frontierList[i] * MSBFS_WORDS], 0, MSBFS_WORDS * sizeof(uint64_t));
+    }
+    for (int i = 0; i < touchedSize; i++) {
+        memset(&seen[(size_t)ws->touched[i] * MSBFS_WORDS], 0, MSBFS_WORDS * sizeof(uint64_t));
+    }
+    ws->frontier = frontier;
+    ws->next = next;
+    ws->frontierList = frontierList;
+    ws->nextList = nextList;
+}
+
+typedef struct MsBfsJob {
+    const Graph* graph;
+    const int* sources;
+    const int* order; // 가까운 출발점끼리 같은 배치에 들어가도록 정렬한 sources 색인
+    int numSources;
+    int maxDist;
+    const unsigned char* countMask;
+    int* counts;
+    int nextSource; // 다음에 가져갈 order 위치 (원자적으로 증가)
+} MsBfsJob;
+
+static void* msbfsWorker(void* arg) {
+    MsBfsJob* job = (MsBfsJob*)arg;
+    MsBfsWorkspace* ws = createMsBfsWorkspace(job->graph->numVertices);
+    
+    int batch[MSBFS_LANES];
+    int batchCounts[MSBFS_LANES];
+    
+    while (1) {
+        int begin = __atomic_fetch_add(&job->nextSource, MSBFS_LANES, __ATOMIC_RELAXED);
+        if (begin >= job->numSources) break;
+        int size = job->numSources - begin < MSBFS_LANES ? job->numSources - begin : MSBFS_LANES;
+        for (int k = 0; k < size; k++) {
+            int index = job->order[begin + k];
+            batch[k] = job->sources ? job->sources[index] : index + 1;
+        }
+        msbfsBatch(job->graph, ws, batch, size, job->maxDist, job->countMask, batchCounts);
+        for (int k = 0; k < size; k++) {
+            job->counts[job->order[begin + k]] = batchCounts[k];
+        }
+    }
+    
+    freeMsBfsWorkspace(ws);
+    return NULL;
+}
+
+// 그래프를 BFS 순서로 훑은 방문 순서대로 sources 색인을 정렬
+// 한 배치의 출발점들이 서로 가까우면 프런티어가 겹쳐서 한 번의 간선 순회가 여러 BFS에 쓰임
+static int* localityOrder(const Graph* graph, const int* sources, int numSources) {
+    int n = graph->numVertices;
+    int* rank = (int*)malloc((n + 1) * sizeof(int));
+    int* queue = (int*)malloc((n + 1) * sizeof(int));
+    for (int v = 1; v <= n; v++) {
+        rank[v] = -1;
+    }
+    
+    int visitedCount = 0;
+    for (int root = 1; root <= n; root++) {
+        if (rank[root] >= 0) continue;
+        int front = 0, rear = 0;
+        rank[root] = visitedCount++;
+        queue[rear++] = root;
+        while (front < rear) {
+            int u = queue[front++];
+            for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+                int v = graph->adj[e];
+                if (rank[v] < 0) {
+                    rank[v] = visitedCount++;
+                    queue[rear++] = v;
+                }
+            }
+        }
+    }
+    
+    // 방문 순위 → sources 색인 (같은 정점이 두 번 들어오지 않는다고 가정)
+    int* byRank = queue;
+    for (int r = 0; r < n; r++) {
+        byRank[r] = -1;
+    }
+    for (int i = 0; i < numSources; i++) {
+        int v = sources ? sources[i] : i + 1;
+        byRank[rank[v]] = i;
+    }
+    int* order = (int*)malloc((numSources > 0 ? numSources : 1) * sizeof(int));
+    int count = 0;
+    for (int r = 0; r < n; r++) {
+        if (byRank[r] >= 0) order[count++] = byRank[r];
+    }
+    
+    free(rank);
+    free(queue);
+    return order;
+}
+
+// sources의 각 정점에서 maxDist 단계 이내 정점 수를 MS-BFS 배치로 나눠 병렬 계산
+// counts[i]가 sources[i]의 결과이며, countMask가 있으면 countMask[v] != 0인 정점만 셈
+// sources가 NULL이면 1번부터 numSources번까지의 정점을 차례로 사용
+void countReachableBitParallel(Graph* graph, const int* sources, int numSources, int maxDist,
+                               const unsigned char* countMask, int* counts, int numThreads) {
+    buildReverseGraph(graph);
+    
+    MsBfsJob job;
+    job.graph = graph;
+    job.sources = sources;
+    job.order = localityOrder(graph, sources, numSources);
+    job.numSources = numSources;
+    job.maxDist = maxDist;
+    job.countMask = countMask;
+    job.counts = counts;
+    job.nextSource = 0;
+    
+    // 일감보다 스레드가 많으면 작업 공간만 낭비하므로 배치 수로 제한
+    int batches = (numSources + MSBFS_LANES - 1) / MSBFS_LANES;
+    numThreads = resolveThreadCount(numThreads);
+    runWorkers(msbfsWorker, &job, numThreads < batches ? numThreads : (batches > 0 ? batches : 1));
+    free((int*)job.order);
+}
+
+// 표본 정점의 평균 k단계 도달 수가 이 값 이상이면 MS-BFS, 미만이면 정점별 제한 BFS가 더 빠름
+// (희소 무작위 그래프의 평균 300 정도에서는 제한 BFS가 3배 빠르고, 평균 1만 이상인 소셜 그래프에서는 MS-BFS가 2배 빠름)
+#define MSBFS_MIN_BALL 1024
+
+// 모든 정점의 maxDist 단계 이내 도달 수 (counts[1..n], 호출자가 해제)
+// 몇 개 정점의 도달 수를 먼저 재어 그래프에 맞는 계산 방식을 고름
+int* countReachableAuto(Graph* graph, int maxDist, int numThreads) {
+    int n = graph->numVertices;
+    int samples = n < 64 ? n : 64;
+    long long total = 0;
+    BfsWorkspace* ws = createBfsWorkspace(n);
+    for (int s = 0; s < samples; s++) {
+        total += countWithinDistance(graph, ws, (int)((long long)s * n / samples) + 1, maxDist);
+    }
+    freeBfsWorkspace(ws);
+    
+    if (samples == 0 || total / samples < MSBFS_MIN_BALL) {
+        return countReachableAll(graph, maxDist, numThreads);
+    }
+    
+    int* counts = (int*)calloc(n + 1, sizeof(int));
+    countReachableBitParallel(graph, NULL, n, maxDist, NULL, counts + 1, numThreads);
+    return counts;
+}
+
+void question3(Graph* graph, int numThreads) {
+    int bestPerson = 1;
+    int maxReachable = 0;
+    int* counts = countReachableAuto(graph, 3, numThreads);
+    
+    for (int i = 1; i <= graph->numVertices; i++) {
+        if (counts[i] > maxReachable) {
+            maxReachable = counts[i];
+            bestPerson = i;
+        }
+    }
+    free(counts);
+    
+    printf("(3) 3단계 이내에 가장 많은 사람(%d명)에게 도달 가능한 사람: %d번\n", 
+           maxReachable, bestPerson);
+}
+
+// 전체 정점 도달 수 계산 시간을 재고, 일부 정점을 bfs 기반 결과와 비교
+void benchmarkReachable(Graph* graph, int maxDist, int numThreads) {
+    int n = graph->numVertices;
+    double t0 = nowSeconds();
+    int* counts = countReachableAll(graph, maxDist, numThreads);
+    double elapsed = nowSeconds() - t0;
+    
+    int* bitCounts = (int*)malloc(n * sizeof(int));
+    t0 = nowSeconds();
+    countReachableBitParallel(graph, NULL, n, maxDist, NULL, bitCounts, numThreads);
+    double bitElapsed = nowSeconds() - t0;
+    int bitMismatches = 0;
+    for (int i = 1; i <= n; i++) {
+        if (bitCounts[i - 1] != counts[i]) bitMismatches++;
+    }
+    free(bitCounts);
+    
+    int samples = n < 32 ? n : 32;
+    int mismatches = 0;
+    double bfsTime = 0;
+    for (int s = 0; s < samples; s++) {
+        int v = (int)((long long)s * n / samples) + 1;
+        double t1 = nowSeconds();
+        int* dist = bfs(graph, v);
+        int expected = 0;
+        for (int i = 1; i <= n; i++) {
+            if (dist[i] <= maxDist) expected++;
+        }
+        bfsTime += nowSeconds() - t1;
+        free(dist);
+        if (expected != counts[v]) mismatches++;
+    }
+    free(counts);
+    
+    printf("[%d단계 도달 수 벤치마크] 스레드 %d개\n", maxDist, resolveThreadCount(numThreads));
+    printf("  countReachableAll      : %.3f s (정점당 %.3f us)\n", elapsed, elapsed * 1e6 / n);
+    printf("  MS-BFS (%d개씩)       : %.3f s (정점당 %.3f us, 불일치 %d)\n",
+           MSBFS_LANES, bitElapsed, bitElapsed * 1e6 / n, bitMismatches);
+    printf("  bfs 기반 (추정)        : %.3f s (정점당 %.3f us)\n",
+           bfsTime / samples * n, bfsTime * 1e6 / samples);
+    printf("  결과 불일치            : %d/%d\n", mismatches, samples);
+}
+
+// (4) 3단계 이내로 모든 사람에게 연락하기 위한 최소 인원 조합
+// start의 maxDist 단계 이내 정점을 모두 커버 처리 (탐색이 끝나면 큐에 그 정점들이 남아 있음)
+static void coverWithinDistance(const Graph* graph, BfsWorkspace* ws, int start, int maxDist,
+                                unsigned char* uncovered) {
+    int reached = countWithinDistance(graph, ws, start, maxDist);
+    for (int k = 0; k < reached; k++) {
+        uncovered[ws->queue[k]] = 0;
+    }
+}
+
+// 전수 그리디: 매 단계 선택되지 않은 모든 정점의 이득을 MS-BFS로 다시 계산
+// selected[1..n]에 선택 여부를 채우고 선택 인원을 반환 (lazy 버전 검증 및 비교용)
+int greedyCoverExhaustive(Graph* graph, int maxDist, int* selected, int numThreads) {
+    int n = graph->numVertices;
+    unsigned char* uncovered = (unsigned char*)malloc(n + 1);
+    int* sources = (int*)calloc(n, sizeof(int));
+    int* gains = (int*)malloc(n * sizeof(int));
+    int selectedCount = 0;
+    
+    // 초기화
+    for (int i = 1; i <= n; i++) {
+        uncovered[i] = 1;
+        selected[i] = 0;
+    }
+    
+    BfsWorkspace* ws = createBfsWorkspace(n);
+    
+    // 그리디 방식: 매번 가장 많은 미커버 노드를 커버하는 노드 선택
+    while (1) {
+        int bestNode = -1;
+        int bestNewCovered = 0;
+        
+        // 선택되지 않은 모든 노드가 새로 커버할 수 있는 노드 수를 MS-BFS로 한꺼번에 계산
+        int numSources = 0;
+        for (int i = 1; i <= n; i++) {
+            if (!selected[i]) sources[numSources++] = i;
+        }
+        countReachableBitParallel(graph, sources, numSources, maxDist, uncovered, gains, numThreads);
+        
+        for (int k = 0; k < numSources; k++) {
+            if (gains[k] > bestNewCovered) {
+                bestNewCovered = gains[k];
+                bestNode = sources[k];
+            }
+        }
+        
+        if (bestNode == -1 || bestNewCovered == 0) break;
+        
+        // 선택된 노드로 커버 업데이트
+        selected[bestNode] = 1;
+        selectedCount++;
+        coverWithinDistance(graph, ws, bestNode, maxDist, uncovered);
+    }
+    
+    freeBfsWorkspace(ws);
+    free(uncovered);
+    free(sources);
+    free(gains);
+    return selectedCount;
+}
+
+// lazy 그리디용 최대 힙 원소 (이득이 크고, 같으면 번호가 작은 정점이 위)
+typedef struct GainEntry {
+    int gain;
+    int vertex;
+} GainEntry;
+
+static inline int gainAbove(GainEntry a, GainEntry b) {
+    return a.gain > b.gain || (a.gain == b.gain && a.vertex < b.vertex);
+}
+
+static void siftDown(GainEntry* heap, int size, int i) {
+    while (1) {
+        int top = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && gainAbove(heap[left], heap[top])) top = left;
+        if (right < size && gainAbove(heap[right], heap[top])) top = right;
+        if (top == i) return;
+        GainEntry tmp = heap[i];
+        heap[i] = heap[top];
+        heap[top] = tmp;
+        i = top;
+    }
+}
+
+// lazy 그리디 (CELF): 커버가 늘수록 이득은 줄기만 하므로 힙에 남은 이득은 상한값
+// 맨 위 정점의 힙 값이 실제 이득과 같으면 바로 선택하고, 아니면 그 정점만 갱신해 제자리로 내려보냄
+// 실제 이득 gain[]은 증분으로 유지: 새로 커버된 정점 c마다 역방향으로 maxDist 단계 안에서
+// c에 닿는 정점들의 이득을 1씩 줄임 (정점마다 한 번만 커버되므로 전체 비용은 처음 계산과 비슷함)
+// 힙 순서가 전수 그리디의 선택 기준(이득 최대, 같으면 작은 번호)과 같아서 결과도 같음
+int greedyCoverLazy(Graph* graph, int maxDist, int* selected, int numThreads, long long* evaluations) {
+    int n = graph->numVertices;
+    unsigned char* uncovered = (unsigned char*)malloc(n + 1);
+    int* newlyCovered = (int*)malloc(n * sizeof(int));
+    GainEntry* heap = (GainEntry*)malloc(n * sizeof(GainEntry));
+    int selectedCount = 0, remaining = n;
+    long long refreshed = 0;
+    
+    // 처음 이득은 전체 정점의 k단계 도달 수
+    int* gain = countReachableAuto(graph, maxDist, numThreads);
+    buildReverseGraph(graph);
+    for (int i = 1; i <= n; i++) {
+        uncovered[i] = 1;
+        selected[i] = 0;
+        heap[i - 1].gain = gain[i];
+        heap[i - 1].vertex = i;
+    }
+    
+    int heapSize = n;
+    for (int i = heapSize / 2 - 1; i >= 0; i--) {
+        siftDown(heap, heapSize, i);
+    }
+    
+    BfsWorkspace* ws = createBfsWorkspace(n);
+    BfsWorkspace* reverseWs = createBfsWorkspace(n);
+    
+    while (remaining > 0 && heapSize > 0) {
+        GainEntry top = heap[0];
+        
+        if (top.gain != gain[top.vertex]) {
+            // 오래된 상한값이면 실제 이득으로 바꿔서 제자리를 찾게 함
+            heap[0].gain = gain[top.vertex];
+            refreshed++;
+            siftDown(heap, heapSize, 0);
+            continue;
+        }
+        
+        // 최신 이득이 가장 크므로 선택
+        if (top.gain == 0) break;
+        heap[0] = heap[--heapSize];
+        siftDown(heap, heapSize, 0);
+        
+        selected[top.vertex] = 1;
+        selectedCount++;
+        
+        int reached = countWithinDistance(graph, ws, top.vertex, maxDist);
+        int newCount = 0;
+        for (int k = 0; k < reached; k++) {
+            int v = ws->queue[k];
+            if (uncovered[v]) {
+                uncovered[v] = 0;
+                newlyCovered[newCount++] = v;
+            }
+        }
+        remaining -= newCount;
+        
+        for (int k = 0; k < newCount; k++) {
+            int count = limitedBfs(graph->revOffsets, graph->revAdj, reverseWs, newlyCovered[k], maxDist);
+            for (int j = 0; j < count; j++) {
+                gain[reverseWs->queue[j]]--;
+            }
+        }
+    }
+    
+    freeBfsWorkspace(ws);
+    freeBfsWorkspace(reverseWs);
+    free(uncovered);
+    free(gain);
+    free(newlyCovered);
+    free(heap);
+    if (evaluations) *evaluations = refreshed;
+    return selectedCount;
+}
+
+void question4(Graph* graph, int numThreads) {
+    int* selected = (int*)malloc((graph->numVertices + 1) * sizeof(int));
+    int selectedCount = greedyCoverLazy(graph, 3, selected, numThreads, NULL);
+    
+    printf("(4) 3단계 이내 전체 커버를 위한 최소 인원(%d명): ", selectedCount);
+    for (int i = 1; i <= graph->numVertices; i++) {
+        if (selected[i]) {
+            printf("%d ", i);
+        }
+    }
+    printf("\n");
+    
+    free(selected);
+}
+
+// 전수 그리디와 lazy 그리디의 소요 시간 비교 (전수 그리디는 정점 수가 limit 이하일 때만 실행)
+#define COVER_EXHAUSTIVE_LIMIT 20000
+
+void benchmarkCover(Graph* graph, int maxDist, int numThreads) {
+    int n = graph->numVertices;
+    int* lazySelected = (int*)malloc((n + 1) * sizeof(int));
+    long long evaluations = 0;
+    
+    double t0 = nowSeconds();
+    int lazyCount = greedyCoverLazy(graph, maxDist, lazySelected, numThreads, &evaluations);
+    double lazyTime = nowSeconds() - t0;
+    
+    printf("[%d단계 커버 벤치마크] 정점 %d\n", maxDist, n);
+    printf("  greedyCoverLazy        : %.3f s (%d명 선택, 힙 갱신 %lld회)\n",
+           lazyTime, lazyCount, evaluations);
+    
+    if (n <= COVER_EXHAUSTIVE_LIMIT) {
+        int* selected = (int*)malloc((n + 1) * sizeof(int));
+        t0 = nowSeconds();
+        int count = greedyCoverExhaustive(graph, maxDist, selected, numThreads);
+        double exhaustiveTime = nowSeconds() - t0;
+        int same = count == lazyCount && memcmp(selected + 1, lazySelected + 1, n * sizeof(int)) == 0;
+        printf("  greedyCoverExhaustive  : %.3f s (%d명 선택, %s)\n",
+               exhaustiveTime, count, same ? "결과 일치" : "결과 불일치");
+        free(selected);
+    } else {
+        printf("  greedyCoverExhaustive  : 생략 (정점 %d개 초과)\n", COVER_EXHAUSTIVE_LIMIT);
+    }
+    
+    free(lazySelected);
+}
+
+// 메인 함수
+// 빌드: gcc -O2 -pthread claude.c -o claude
+// 사용법: claude [-g 그래프파일 | -G 정점수] [-s 스냅샷파일] [-v] [-b] [-q 질의파일] [-t 스레드수]
+//   -G: 파일 대신 평균 차수 8인 무작위 그래프를 만들어 사용 (벤치마크용)
+//   -s: 스냅샷이 있으면 텍스트 파싱 없이 매핑하고, 없거나 오래되었으면 새로 만듦
+//   -v: 스냅샷을 매핑할 때 체크섬까지 검증
+//   -b: 네 가지 질문 대신 BFS/도달 수/커버 벤치마크 실행
+//   -q: 네 가지 질문 대신 "src dest" 줄을 읽어 "src dest 거리"를 출력 ("-"이면 표준 입력)
+//       질의 결과만 표준 출력에 쓰고 진행 메시지는 표준 에러로 보냄
+//   -t: 병렬 계산에 쓸 스레드 수 (기본값은 CPU 코어 수)
+int main(int argc, char* argv[]) {
+    const char* graphFile = "kb.txt";
+    const char* snapshotFile = NULL;
+    int verify = 0;
+    int benchmark = 0;
+    int numThreads = 0;
+    int generatedVertices = 0;
+    const char* queryFile = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-g") && i + 1 < argc) {
+            graphFile = argv[++i];
+        } else if (!strcmp(argv[i], "-G") && i + 1 < argc) {
+            generatedVertices = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            snapshotFile = argv[++i];
+        } else if (!strcmp(argv[i], "-v")) {
+            verify = 1;
+        } else if (!strcmp(argv[i], "-b")) {
+            benchmark = 1;
+        } else if (!strcmp(argv[i], "-q") && i + 1 < argc) {
+            queryFile = argv[++i];
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else {
+            printf("사용법: %s [-g 그래프파일 | -G 정점수] [-s 스냅샷파일] [-v] [-b] [-q 질의파일] [-t 스레드수]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    
+    FILE* info = queryFile ? stderr : stdout;
+    fprintf(info, "=== 케빈 베이컨 게임 ===\n");
+    
+    // 그래프 파일 읽기
+    Graph* graph = generatedVertices > 0 ? generateRandomGraph(generatedVertices, 8, 2024)
+                                         : loadGraph(graphFile, snapshotFile, verify);
+    if (!graph) {
+        fprintf(info, "그래프를 읽을 수 없습니다.\n");
+        return 1;
+    }
+    
+    fprintf(info, "그래프 로드 완료: %d명의 사람\n\n", graph->numVertices);
+    
+    if (queryFile) {
+        int fd = strcmp(queryFile, "-") ? open(queryFile, O_RDONLY) : STDIN_FILENO;
+        if (fd < 0) {
+            fprintf(stderr, "질의 파일을 열 수 없습니다: %s\n", queryFile);
+            freeGraph(graph);
+            return 1;
+        }
+        double start = nowSeconds();
+        long long answered = answerDistanceQueries(graph, fd, stdout, numThreads);
+        double elapsed = nowSeconds() - start;
+        fprintf(stderr, "질의 %lld개 처리: %.3f s (%.0f건/초)\n",
+                answered, elapsed, elapsed > 0 ? answered / elapsed : 0);
+        if (fd != STDIN_FILENO) close(fd);
+        freeGraph(graph);
+        return 0;
+    }
+    
+    if (benchmark) {
+        benchmarkBfs(graph, 32);
+        benchmarkDistance(graph, 256);
+        benchmarkComponents(graph, numThreads);
+        benchmarkReachable(graph, 3, numThreads);
+        benchmarkCover(graph, 3, numThreads);
+        freeGraph(graph);
+        return 0;
+    }
+    
+    // 4가지 질문 해결
+    question1(graph);
+    question2(graph, numThreads);
+    question3(graph, numThreads);
+    question4(graph, numThreads);
+    
+    // 메모리 해제
+    freeGraph(graph);
+    
+    return 0;
+}
@@ -1,281 +1,3510 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-#include <math.h>
-
-#define MAX_LINE 8192
-#define MAX_TOKENS 1000
-#define MAX_TOKEN_LEN 64
-#define STACK_SIZE 1000
-
-typedef struct {
-    double data[STACK_SIZE];
-    int top;
-} DoubleStack;
-
-typedef struct {
-    char data[STACK_SIZE][MAX_TOKEN_LEN];
-    int top;
-} StringStack;
-
-void initDoubleStack(DoubleStack *s) { s->top = -1; }
-int isEmptyDouble(DoubleStack *s) { return s->top == -1; }
-void pushDouble(DoubleStack *s, double val) { s->data[++s->top] = val; }
-double popDouble(DoubleStack *s) { return s->top < 0 ? 0 : s->data[s->top--]; }
-
-void initStringStack(StringStack *s) { s->top = -1; }
-int isEmptyString(StringStack *s) { return s->top == -1; }
-void pushString(StringStack *s, const char *val) { strcpy(s->data[++s->top], val); }
-char* popString(StringStack *s) { return s->top < 0 ? NULL : s->data[s->top--]; }
-char* peekString(StringStack *s) { return s->top < 0 ? NULL : s->data[s->top]; }
-
-int precedence(char *op) {
-    if (!strcmp(op, "+") || !strcmp(op, "-")) return 1;
-    if (!strcmp(op, "*") || !strcmp(op, "/")) return 2;
-    if (!strcmp(op, "^")) return 3;
-    return 0;
-}
-
-int isOperator(char *token) {
-    return !strcmp(token, "+") || !strcmp(token, "-") ||
-           !strcmp(token, "*") || !strcmp(token, "/") || !strcmp(token, "^");
-}
-
-int isNumber(const char *token) {
-    char *end;
-    strtod(token, &end);
-    return end != token && *end == '\0';
-}
-
-void preprocess_line(char *line) {
-    char temp[MAX_LINE];
-    int i = 0, j = 0;
-
-    while (line[i]) {
-        // 유니코드 하이픈 — or –
-        if ((unsigned char)line[i] == 0xE2 &&
-            (unsigned char)line[i + 1] == 0x80 &&
-            ((unsigned char)line[i + 2] == 0x93 || (unsigned char)line[i + 2] == 0x94)) {
-            temp[j++] = '-';
-            i += 3;
-        }
-        // '**' → '^'
-        else if (line[i] == '*' && line[i + 1] == '*') {
-            temp[j++] = '^';
-            i += 2;
-        }
-        // e 상수
-        else if (line[i] == 'e' && (i == 0 || !isalnum(line[i - 1])) && !isalnum(line[i + 1])) {
-            strcpy(&temp[j], "2.7182818");
-            j += strlen("2.7182818");
-            i++;
-        }
-        // f 제거 (float 접미사)
-        else if (line[i] == 'f') {
-            i++; // skip
-        }
-        // -( → -1*( 치환
-        else if (line[i] == '-' && line[i + 1] == '(') {
-            strcpy(&temp[j], "-1*(");
-            j += 4;
-            i += 2;
-        }
-        // 나머지 그대로 복사
-        else {
-            temp[j++] = line[i++];
-        }
-    }
-
-    temp[j] = '\0';
-    strcpy(line, temp);
-}
-
-
-int tokenize(char *line, char tokens[][MAX_TOKEN_LEN]) {
-    int count = 0;
-    char *p = line;
-
-    while (*p) {
-        while (isspace(*p)) p++;
-        if (!*p) break;
-
-        // 괄호 안 음수 처리: (-1.0) → 하나의 숫자
-        if (*p == '(' && (*(p + 1) == '-' || *(p + 1) == '+') &&
-            (isdigit(*(p + 2)) || *(p + 2) == '.')) {
-            int i = 0;
-            p++; // skip '('
-            tokens[count][i++] = *p++;
-            while (*p && (isdigit(*p) || *p == '.' || *p == 'e' || *p == 'E' ||
-                          *p == '-' || *p == '+')) {
-                tokens[count][i++] = *p++;
-                if (i >= MAX_TOKEN_LEN - 1) break;
-            }
-            tokens[count][i] = '\0';
-            count++;
-            if (*p == ')') p++;
-            continue;
-        }
-
-        // 단항 연산자 위치에서 -3.5e0 인식
-        if (strchr("+-", *p) &&
-            (count == 0 || isOperator(tokens[count - 1]) || !strcmp(tokens[count - 1], "("))) {
-            int i = 0;
-            tokens[count][i++] = *p++;
-            while (isdigit(*p) || *p == '.') tokens[count][i++] = *p++;
-            if (*p == 'e' || *p == 'E') {
-                tokens[count][i++] = *p++;
-                if (*p == '-' || *p == '+') tokens[count][i++] = *p++;
-                while (isdigit(*p)) tokens[count][i++] = *p++;
-            }
-            tokens[count][i] = '\0';
-            count++;
-            continue;
-        }
-
-        if (strchr("()+-*/^", *p)) {
-            tokens[count][0] = *p++;
-            tokens[count][1] = '\0';
-            count++;
-        } else if (isdigit(*p) || *p == '.') {
-            int i = 0;
-            while (*p && (isdigit(*p) || *p == '.' || *p == 'e' || *p == 'E' ||
-                          *p == '-' || *p == '+')) {
-                tokens[count][i++] = *p++;
-                if (i >= MAX_TOKEN_LEN - 1) break;
-            }
-            tokens[count][i] = '\0';
-            count++;
-        } else {
-            return -1;
-        }
-    }
-
-    return count;
-}
-
-int toPostfix(char tokens[][MAX_TOKEN_LEN], int count, char output[][MAX_TOKEN_LEN]) {
-    StringStack opStack;
-    initStringStack(&opStack);
-    int outCount = 0;
-
-    for (int i = 0; i < count; i++) {
-        if (isNumber(tokens[i])) {
-            strcpy(output[outCount++], tokens[i]);
-        } else if (!strcmp(tokens[i], "(")) {
-            pushString(&opStack, tokens[i]);
-        } else if (!strcmp(tokens[i], ")")) {
-            while (!isEmptyString(&opStack) && strcmp(peekString(&opStack), "(")) {
-                strcpy(output[outCount++], popString(&opStack));
-            }
-            if (isEmptyString(&opStack)) return -1;
-            popString(&opStack);
-        } else if (isOperator(tokens[i])) {
-            while (!isEmptyString(&opStack) && isOperator(peekString(&opStack)) &&
-                   precedence(peekString(&opStack)) >= precedence(tokens[i])) {
-                strcpy(output[outCount++], popString(&opStack));
-            }
-            pushString(&opStack, tokens[i]);
-        } else {
-            return -1;
-        }
-    }
-
-    while (!isEmptyString(&opStack)) {
-        if (!strcmp(peekString(&opStack), "(")) return -1;
-        strcpy(output[outCount++], popString(&opStack));
-    }
-
-    return outCount;
-}
-
-int evaluatePostfix(char tokens[][MAX_TOKEN_LEN], int count, double *result) {
-    DoubleStack stack;
-    initDoubleStack(&stack);
-
-    for (int i = 0; i < count; i++) {
-        if (isNumber(tokens[i])) {
-            pushDouble(&stack, strtod(tokens[i], NULL));
-        } else if (isOperator(tokens[i])) {
-            if (stack.top < 1) return 0;
-            double b = popDouble(&stack);
-            double a = popDouble(&stack);
-            double r = 0;
-            if (!strcmp(tokens[i], "+")) r = a + b;
-            else if (!strcmp(tokens[i], "-")) r = a - b;
-            else if (!strcmp(tokens[i], "*")) r = a * b;
-            else if (!strcmp(tokens[i], "/")) {
-                if (b == 0) return 0;
-                r = a / b;
-            } else if (!strcmp(tokens[i], "^")) r = pow(a, b);
-            pushDouble(&stack, r);
-        } else {
-            return 0;
-        }
-    }
-
-    if (stack.top != 0) return 0;
-    *result = popDouble(&stack);
-    return 1;
-}
-
-int isInvalidLine(const char *line) {
-    for (int i = 0; line[i]; i++) {
-        if (line[i] == '{' || line[i] == '}' || line[i] == '[' || line[i] == ']')
-            return 1;
-    }
-    return strlen(line) == 0 || strspn(line, " \t\r\n") == strlen(line);
-}
-
-int main() {
-    FILE *fp = fopen("input.txt", "r");
-    if (!fp) {
-        perror("input.txt");
-        return 1;
-    }
-
-    char line[MAX_LINE];
-    while (fgets(line, sizeof(line), fp)) {
-        line[strcspn(line, "\r\n")] = 0;
-
-        if (isInvalidLine(line)) {
-            printf("Invalid Expression\n");
-            continue;
-        }
-
-        preprocess_line(line);
-
-        char tokens[MAX_TOKENS][MAX_TOKEN_LEN];
-        int tokenCount = tokenize(line, tokens);
-        if (tokenCount < 1) {
-            printf("Invalid Expression\n");
-            continue;
-        }
-
-        char postfix[MAX_TOKENS][MAX_TOKEN_LEN];
-        int postfixCount = toPostfix(tokens, tokenCount, postfix);
-        if (postfixCount < 1) {
-            printf("Invalid Expression\n");
-            continue;
-        }
-
-        // 출력: 후위 표기식
-        printf("Postfix: ");
-        for (int i = 0; i < postfixCount; i++) {
-            printf("%s ", postfix[i]);
-        }
-        printf("\n");
-
-        // 출력: 결과
-        double result;
-        if (!evaluatePostfix(postfix, postfixCount, &result)) {
-            printf("Result: Invalid Expression\n");
-        } else {
-            printf("Result: %.2f\n", result);
-        }
-    }
-
-    fclose(fp);
-    return 0;
-}
-
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <float.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_LINE 8192
+#define MAX_TOKENS 1000
+#define MAX_TOKEN_LEN 64
+#define STACK_SIZE 1000
+
+typedef struct {
+    double data[STACK_SIZE];
+    int top;
+} DoubleStack;
+
+typedef struct {
+    char data[STACK_SIZE][MAX_TOKEN_LEN];
+    int top;
+} StringStack;
+
+void initDoubleStack(DoubleStack *s) { s->top = -1; }
+int isEmptyDouble(DoubleStack *s) { return s->top == -1; }
+void pushDouble(DoubleStack *s, double val) { s->data[++s->top] = val; }
+double popDouble(DoubleStack *s) { return s->top < 0 ? 0 : s->data[s->top--]; }
+
+void initStringStack(StringStack *s) { s->top = -1; }
+int isEmptyString(StringStack *s) { return s->top == -1; }
+void pushString(StringStack *s, const char *val) { strcpy(s->data[++s->top], val); }
+char* popString(StringStack *s) { return s->top < 0 ? NULL : s->data[s->top--]; }
+char* peekString(StringStack *s) { return s->top < 0 ? NULL : s->data[s->top]; }
+
+// 바이트코드 명령 (후위 표기 순서로 한 바이트씩)
+typedef enum {
+    OP_PUSH, // 다음 상수를 스택에 올림
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_VAR,  // 다음 변수 값을 스택에 올림
+    OP_NEG,  // 부호 반전 (-1 * x와 같은 값, 최적화기나 확장 언어의 단항 -가 만듦)
+    OP_SQR,  // x^2 (최적화기가 만듦)
+    OP_POWI, // x^n, n은 다음 상수인 0..POW_MAX_EXPONENT 정수 (최적화기가 만듦)
+    OP_MOD,  // 여기부터는 확장 언어(-x)에서만 나옴
+    OP_SQRT,
+    OP_SIN,
+    OP_COS,
+    OP_TAN,
+    OP_LOG,
+    OP_EXP,
+    OP_ABS,
+    OP_MIN,
+    OP_MAX,
+    OP_COUNT
+} Opcode;
+
+// 연산자와 함수 표 (opcode 순서, 출력 이름도 여기서 가져옴)
+typedef enum {
+    OPERATOR_NONE,     // 이름으로 찾지 않는 명령 (PUSH, VAR, 최적화기가 만드는 명령)
+    OPERATOR_BINARY,
+    OPERATOR_PREFIX,   // 단항 - (이름 대신 피연산자 자리의 -로 씀)
+    OPERATOR_FUNCTION  // 이름(인자, ...)
+} OperatorKind;
+
+typedef struct {
+    const char *name;
+    unsigned char kind;
+    unsigned char arity;            // 피연산자 수
+    unsigned char precedence;       // 연산자 우선순위 (함수는 0, 단항 -는 * / %보다 강하고 ^보다 약함)
+    unsigned char rightAssociative; // 확장 언어에서 오른쪽 결합 (기본 언어는 모두 왼쪽 결합)
+    unsigned char extended;         // 확장 언어에서만 씀
+} OperatorInfo;
+
+static const OperatorInfo operatorTable[OP_COUNT] = {
+    [OP_PUSH] = { "", OPERATOR_NONE, 0, 0, 0, 0 },
+    [OP_ADD] = { "+", OPERATOR_BINARY, 2, 1, 0, 0 },
+    [OP_SUB] = { "-", OPERATOR_BINARY, 2, 1, 0, 0 },
+    [OP_MUL] = { "*", OPERATOR_BINARY, 2, 2, 0, 0 },
+    [OP_DIV] = { "/", OPERATOR_BINARY, 2, 2, 0, 0 },
+    [OP_POW] = { "^", OPERATOR_BINARY, 2, 4, 1, 0 },
+    [OP_VAR] = { "", OPERATOR_NONE, 0, 0, 0, 0 },
+    [OP_NEG] = { "neg", OPERATOR_PREFIX, 1, 3, 1, 1 },
+    [OP_SQR] = { "sqr", OPERATOR_NONE, 1, 0, 0, 0 },
+    [OP_POWI] = { "powi", OPERATOR_NONE, 1, 0, 0, 0 },
+    [OP_MOD] = { "%", OPERATOR_BINARY, 2, 2, 0, 1 },
+    [OP_SQRT] = { "sqrt", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_SIN] = { "sin", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_COS] = { "cos", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_TAN] = { "tan", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_LOG] = { "log", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_EXP] = { "exp", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_ABS] = { "abs", OPERATOR_FUNCTION, 1, 0, 0, 1 },
+    [OP_MIN] = { "min", OPERATOR_FUNCTION, 2, 0, 0, 1 },
+    [OP_MAX] = { "max", OPERATOR_FUNCTION, 2, 0, 0, 1 },
+};
+
+// 이름 → opcode 완전 해시 (첫 글자, 끝 글자, 길이로 표의 이름이 모두 다른 칸에 들어감)
+// 이름을 더해 칸이 겹치면 -Woverride-init 경고가 나므로 곱하는 수를 바꿔 다시 맞춤
+#define OPERATOR_HASH(first, last, len) (((unsigned char)(first) + 21 * (unsigned char)(last) + 4 * (len)) & 31)
+
+static const unsigned char operatorSlot[32] = {
+    [OPERATOR_HASH('+', '+', 1)] = OP_ADD,
+    [OPERATOR_HASH('-', '-', 1)] = OP_SUB,
+    [OPERATOR_HASH('*', '*', 1)] = OP_MUL,
+    [OPERATOR_HASH('/', '/', 1)] = OP_DIV,
+    [OPERATOR_HASH('^', '^', 1)] = OP_POW,
+    [OPERATOR_HASH('n', 'g', 3)] = OP_NEG,
+    [OPERATOR_HASH('s', 'r', 3)] = OP_SQR,
+    [OPERATOR_HASH('p', 'i', 4)] = OP_POWI,
+    [OPERATOR_HASH('%', '%', 1)] = OP_MOD,
+    [OPERATOR_HASH('s', 't', 4)] = OP_SQRT,
+    [OPERATOR_HASH('s', 'n', 3)] = OP_SIN,
+    [OPERATOR_HASH('c', 's', 3)] = OP_COS,
+    [OPERATOR_HASH('t', 'n', 3)] = OP_TAN,
+    [OPERATOR_HASH('l', 'g', 3)] = OP_LOG,
+    [OPERATOR_HASH('e', 'p', 3)] = OP_EXP,
+    [OPERATOR_HASH('a', 's', 3)] = OP_ABS,
+    [OPERATOR_HASH('m', 'n', 3)] = OP_MIN,
+    [OPERATOR_HASH('m', 'x', 3)] = OP_MAX,
+};
+
+// 이름 [name, name + len)의 opcode (표에 없으면 -1)
+int findOperator(const char *name, int len) {
+    if (len <= 0) return -1;
+    int op = operatorSlot[OPERATOR_HASH(name[0], name[len - 1], len)];
+    const char *entry = operatorTable[op].name;
+    if (op == OP_PUSH || (int)strlen(entry) != len || memcmp(entry, name, len)) return -1;
+    return op;
+}
+
+// 기본 언어의 다섯 연산자 중 하나이면 그 opcode (아니면 -1)
+static int baseOperator(const char *token) {
+    int op = findOperator(token, (int)strlen(token));
+    return op >= 0 && operatorTable[op].kind == OPERATOR_BINARY && !operatorTable[op].extended ? op : -1;
+}
+
+int precedence(char *op) {
+    int code = baseOperator(op);
+    return code >= 0 ? operatorTable[code].precedence : 0;
+}
+
+int isOperator(char *token) {
+    return baseOperator(token) >= 0;
+}
+
+int isNumber(const char *token) {
+    char *end;
+    strtod(token, &end);
+    return end != token && *end == '\0';
+}
+
+static int isIdentifierChar(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// 기준 구현(-r)용 전처리: 줄을 고쳐 쓴 뒤 tokenize에 넘김
+void preprocess_line(char *line) {
+    char temp[MAX_LINE];
+    int i = 0, j = 0;
+
+    while (line[i]) {
+        // 유니코드 하이픈 — or –
+        if ((unsigned char)line[i] == 0xE2 &&
+            (unsigned char)line[i + 1] == 0x80 &&
+            ((unsigned char)line[i + 2] == 0x93 || (unsigned char)line[i + 2] == 0x94)) {
+            temp[j++] = '-';
+            i += 3;
+        }
+        // '**' → '^'
+        else if (line[i] == '*' && line[i + 1] == '*') {
+            temp[j++] = '^';
+            i += 2;
+        }
+        // e 상수
+        else if (line[i] == 'e' && (i == 0 || !isalnum(line[i - 1])) && !isalnum(line[i + 1])) {
+            strcpy(&temp[j], "2.7182818");
+            j += strlen("2.7182818");
+            i++;
+        }
+        // f 제거 (float 접미사)
+        else if (line[i] == 'f') {
+            i++; // skip
+        }
+        // -( → -1*( 치환
+        else if (line[i] == '-' && line[i + 1] == '(') {
+            strcpy(&temp[j], "-1*(");
+            j += 4;
+            i += 2;
+        }
+        // 나머지 그대로 복사
+        else {
+            temp[j++] = line[i++];
+        }
+    }
+
+    temp[j] = '\0';
+    strcpy(line, temp);
+}
+
+
+int tokenize(char *line, char tokens[][MAX_TOKEN_LEN]) {
+    int count = 0;
+    char *p = line;
+
+    while (*p) {
+        while (isspace(*p)) p++;
+        if (!*p) break;
+        if (count == MAX_TOKENS) return -1; // 토큰 배열이 넘치기 전에 거부
+
+        // 괄호 안 음수 처리: (-1.0) → 하나의 숫자
+        if (*p == '(' && (*(p + 1) == '-' || *(p + 1) == '+') &&
+            (isdigit(*(p + 2)) || *(p + 2) == '.')) {
+            int i = 0;
+            p++; // skip '('
+            tokens[count][i++] = *p++;
+            while (*p && (isdigit(*p) || *p == '.' || *p == 'e' || *p == 'E' ||
+                          *p == '-' || *p == '+')) {
+                tokens[count][i++] = *p++;
+                if (i >= MAX_TOKEN_LEN - 1) break;
+            }
+            tokens[count][i] = '\0';
+            count++;
+            if (*p == ')') p++;
+            continue;
+        }
+
+        // 단항 연산자 위치에서 -3.5e0 인식
+        if (strchr("+-", *p) &&
+            (count == 0 || isOperator(tokens[count - 1]) || !strcmp(tokens[count - 1], "("))) {
+            int i = 0;
+            tokens[count][i++] = *p++;
+            while (isdigit(*p) || *p == '.') tokens[count][i++] = *p++;
+            if (*p == 'e' || *p == 'E') {
+                tokens[count][i++] = *p++;
+                if (*p == '-' || *p == '+') tokens[count][i++] = *p++;
+                while (isdigit(*p)) tokens[count][i++] = *p++;
+            }
+            tokens[count][i] = '\0';
+            count++;
+            continue;
+        }
+
+        if (strchr("()+-*/^", *p)) {
+            tokens[count][0] = *p++;
+            tokens[count][1] = '\0';
+            count++;
+        } else if (isdigit(*p) || *p == '.') {
+            int i = 0;
+            while (*p && (isdigit(*p) || *p == '.' || *p == 'e' || *p == 'E' ||
+                          *p == '-' || *p == '+')) {
+                tokens[count][i++] = *p++;
+                if (i >= MAX_TOKEN_LEN - 1) break;
+            }
+            tokens[count][i] = '\0';
+            count++;
+        } else {
+            return -1;
+        }
+    }
+
+    return count;
+}
+
+int toPostfix(char tokens[][MAX_TOKEN_LEN], int count, char output[][MAX_TOKEN_LEN]) {
+    StringStack opStack;
+    initStringStack(&opStack);
+    int outCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (isNumber(tokens[i])) {
+            strcpy(output[outCount++], tokens[i]);
+        } else if (!strcmp(tokens[i], "(")) {
+            pushString(&opStack, tokens[i]);
+        } else if (!strcmp(tokens[i], ")")) {
+            while (!isEmptyString(&opStack) && strcmp(peekString(&opStack), "(")) {
+                strcpy(output[outCount++], popString(&opStack));
+            }
+            if (isEmptyString(&opStack)) return -1;
+            popString(&opStack);
+        } else if (isOperator(tokens[i])) {
+            while (!isEmptyString(&opStack) && isOperator(peekString(&opStack)) &&
+                   precedence(peekString(&opStack)) >= precedence(tokens[i])) {
+                strcpy(output[outCount++], popString(&opStack));
+            }
+            pushString(&opStack, tokens[i]);
+        } else {
+            return -1;
+        }
+    }
+
+    while (!isEmptyString(&opStack)) {
+        if (!strcmp(peekString(&opStack), "(")) return -1;
+        strcpy(output[outCount++], popString(&opStack));
+    }
+
+    return outCount;
+}
+
+int evaluatePostfix(char tokens[][MAX_TOKEN_LEN], int count, double *result) {
+    DoubleStack stack;
+    initDoubleStack(&stack);
+
+    for (int i = 0; i < count; i++) {
+        int op;
+        if (isNumber(tokens[i])) {
+            pushDouble(&stack, strtod(tokens[i], NULL));
+        } else if ((op = baseOperator(tokens[i])) >= 0) {
+            if (stack.top < 1) return 0;
+            double b = popDouble(&stack);
+            double a = popDouble(&stack);
+            double r = 0;
+            switch (op) {
+            case OP_ADD: r = a + b; break;
+            case OP_SUB: r = a - b; break;
+            case OP_MUL: r = a * b; break;
+            case OP_DIV:
+                if (b == 0) return 0;
+                r = a / b;
+                break;
+            case OP_POW: r = pow(a, b); break;
+            }
+            pushDouble(&stack, r);
+        } else {
+            return 0;
+        }
+    }
+
+    if (stack.top != 0) return 0;
+    *result = popDouble(&stack);
+    return 1;
+}
+
+int isInvalidLine(const char *line) {
+    for (int i = 0; line[i]; i++) {
+        if (line[i] == '{' || line[i] == '}' || line[i] == '[' || line[i] == ']')
+            return 1;
+    }
+    return strlen(line) == 0 || strspn(line, " \t\r\n") == strlen(line);
+}
+
+// NUL로 끝나지 않는 줄 [line, line + len)에 대한 isInvalidLine (NUL이 있으면 거기서 끝난 것으로 봄)
+int isInvalidText(const char *line, size_t len) {
+    int blank = 1;
+    for (size_t i = 0; i < len && line[i]; i++) {
+        if (line[i] == '{' || line[i] == '}' || line[i] == '[' || line[i] == ']')
+            return 1;
+        if (line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && line[i] != '\n') blank = 0;
+    }
+    return blank;
+}
+
+// 토큰 분리기: 원문 줄 위에서 전처리 규칙(유니코드 하이픈, **, e 상수, f 접미사, -( 치환)을 바로 적용하며
+// 토큰 기록을 만듦 (preprocess_line처럼 줄을 고쳐 쓰지 않고 두 번째 버퍼도 쓰지 않음)
+// 토큰 글자는 보통 원문을 그대로 가리키고, 치환된 글자가 섞인 토큰만 영역에 따로 씀
+typedef enum {
+    TOKEN_NUMBER,
+    TOKEN_VARIABLE,
+    TOKEN_OPERATOR, // op는 '+', '-', '*', '/', '^' 중 하나 (확장 언어는 '%'도)
+    TOKEN_OPEN,
+    TOKEN_CLOSE,
+    TOKEN_NEGATE,   // 변수 앞의 단항 - (변수 모드), 피연산자 자리의 단항 - (확장 언어)
+    TOKEN_FUNCTION, // 확장 언어의 함수 이름 (op는 opcode)
+    TOKEN_COMMA     // 확장 언어의 인자 구분
+} TokenKind;
+
+// lexExpression의 flags
+#define LEX_VARIABLES 1 // 이름을 변수로 받음
+#define LEX_EXTENDED 2  // 확장 언어 (단항 -, %, 함수, 오른쪽 결합 ^)
+
+// 입력 줄과 표 수식을 확장 언어로 읽을지 (main에서 -x로 켬)
+static int extendedLanguage = 0;
+
+typedef struct {
+    unsigned char kind;
+    char op;
+    int offset;       // 토큰이 시작하는 원문 위치
+    int length;
+    const char *text; // 토큰 글자 (원문 또는 영역 안)
+    double value;     // TOKEN_NUMBER의 값
+} Token;
+
+// 토큰 기록과 치환된 토큰 글자를 담는 영역 (줄마다 비우고 다시 씀, 모자라면 늘림)
+typedef struct {
+    Token *tokens;
+    int count;
+    int capacity;
+    char *text;          // 치환된 글자가 섞인 토큰의 글자
+    size_t textLength;
+    size_t textCapacity;
+    char *number;        // strtod에 넘길 NUL로 끝나는 숫자 사본
+    size_t numberCapacity;
+    int flags;           // 이 토큰열을 만든 lexExpression의 flags
+} TokenArena;
+
+void initTokenArena(TokenArena *arena) {
+    memset(arena, 0, sizeof(*arena));
+}
+
+void freeTokenArena(TokenArena *arena) {
+    free(arena->tokens);
+    free(arena->text);
+    free(arena->number);
+    initTokenArena(arena);
+}
+
+// 전처리 규칙을 적용한 글자를 하나씩 내주는 커서 (앞의 세 글자까지 미리 볼 수 있음)
+typedef struct {
+    const char *line;
+    int length;
+    int variables;         // 변수 모드나 확장 언어: 이름은 통째로 두고 f는 숫자 바로 뒤일 때만 제거
+    int extended;          // 확장 언어: -( 치환을 하지 않음 (단항 -로 처리)
+    int raw;               // 다음에 읽을 원문 위치
+    int identifierEnd;     // 이 위치 전까지는 변수 이름이라 그대로 내줌
+    const char *expansion; // 펼치는 중인 치환 문자열
+    int expansionSource;   // 그 치환이 시작된 원문 위치
+    char ahead[4];         // 미리 읽은 글자 (aheadFirst부터 aheadCount개, 네 칸을 돌려 씀)
+    int aheadSource[4];    // 그 글자가 나온 원문 위치
+    unsigned char aheadPlain[4]; // 원문 글자 그대로인지 (치환으로 생긴 글자는 0)
+    int aheadFirst;
+    int aheadCount;
+} Lexer;
+
+// C 로캘의 isdigit/isspace와 같음 (글자마다 여러 번 부르므로 표를 거치지 않게 함)
+static inline int isDigit(char c) { return c >= '0' && c <= '9'; }
+static inline int isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+static char rawAt(const Lexer *lx, int i) {
+    return i < lx->length ? lx->line[i] : '\0';
+}
+
+// 전처리 규칙이 걸릴 수 있는 글자 (유니코드 하이픈의 첫 바이트, *, e, f, -, 변수 이름 첫 글자)
+static int isRewriteStart(const Lexer *lx, char c) {
+    return (unsigned char)c == 0xE2 || c == '*' || c == 'e' || c == 'f' || c == '-' ||
+           (lx->variables && (isalpha((unsigned char)c) || c == '_'));
+}
+
+// 전처리된 글자 하나를 읽음 (줄 끝이면 0)
+static inline char decodeChar(Lexer *lx, int *source, unsigned char *plain) {
+    for (;;) {
+        if (lx->expansion && *lx->expansion) {
+            *source = lx->expansionSource;
+            *plain = 0;
+            return *lx->expansion++;
+        }
+        int i = lx->raw;
+        if (i >= lx->length) return '\0';
+        char c = lx->line[i];
+        *source = i;
+        *plain = 1;
+        if (i < lx->identifierEnd || !isRewriteStart(lx, c)) {
+            lx->raw++;
+            return c;
+        }
+
+        // 유니코드 하이픈 — or –
+        if ((unsigned char)c == 0xE2 && (unsigned char)rawAt(lx, i + 1) == 0x80 &&
+            ((unsigned char)rawAt(lx, i + 2) == 0x93 || (unsigned char)rawAt(lx, i + 2) == 0x94)) {
+            lx->raw += 3;
+            *plain = 0;
+            return '-';
+        }
+        // '**' → '^'
+        if (c == '*' && rawAt(lx, i + 1) == '*') {
+            lx->raw += 2;
+            *plain = 0;
+            return '^';
+        }
+        // e 상수
+        if (c == 'e' && (i == 0 || !isalnum((unsigned char)lx->line[i - 1])) &&
+            !isalnum((unsigned char)rawAt(lx, i + 1)) &&
+            !(lx->variables && ((i > 0 && lx->line[i - 1] == '_') || rawAt(lx, i + 1) == '_'))) {
+            lx->expansion = "2.7182818";
+            lx->expansionSource = i;
+            lx->raw++;
+            continue;
+        }
+        // f 제거 (float 접미사, 3.f처럼 . 뒤의 f도 이름보다 먼저 봄)
+        if (c == 'f' && (!lx->variables ||
+                         (i > 0 && (isDigit(lx->line[i - 1]) || lx->line[i - 1] == '.')))) {
+            lx->raw++;
+            continue;
+        }
+        // 변수 이름은 통째로 그대로
+        if (lx->variables && (isalpha((unsigned char)c) || c == '_') &&
+            (i == 0 || !isIdentifierChar(lx->line[i - 1]))) {
+            int end = i;
+            while (end < lx->length && isIdentifierChar(lx->line[end])) end++;
+            lx->identifierEnd = end;
+            continue;
+        }
+        // -( → -1*( 치환
+        if (c == '-' && rawAt(lx, i + 1) == '(' && !lx->extended) {
+            lx->expansion = "-1*(";
+            lx->expansionSource = i;
+            lx->raw += 2;
+            continue;
+        }
+        lx->raw++;
+        return c;
+    }
+}
+
+// k번째 뒤의 전처리된 글자 (k < 3, 줄 끝이면 0)
+static inline char peekChar(Lexer *lx, int k) {
+    while (lx->aheadCount <= k) {
+        int n = (lx->aheadFirst + lx->aheadCount) & 3;
+        lx->ahead[n] = decodeChar(lx, &lx->aheadSource[n], &lx->aheadPlain[n]);
+        if (!lx->ahead[n]) return '\0';
+        lx->aheadCount++;
+    }
+    return lx->ahead[(lx->aheadFirst + k) & 3];
+}
+
+static inline void advanceChar(Lexer *lx) {
+    lx->aheadFirst = (lx->aheadFirst + 1) & 3;
+    lx->aheadCount--;
+}
+
+static Token *addToken(TokenArena *arena, Lexer *lx, TokenKind kind) {
+    if (arena->count == arena->capacity) {
+        arena->capacity = arena->capacity ? arena->capacity * 2 : 64;
+        arena->tokens = realloc(arena->tokens, arena->capacity * sizeof(Token));
+    }
+    Token *tok = &arena->tokens[arena->count++];
+    tok->kind = (unsigned char)kind;
+    tok->op = peekChar(lx, 0);
+    tok->offset = lx->aheadSource[lx->aheadFirst];
+    tok->length = 0;
+    tok->text = NULL; // NULL이면 원문 [offset, offset + length)
+    tok->value = 0;
+    return tok;
+}
+
+// 다음 글자를 토큰에 붙임 (원문에서 이어지지 않는 글자가 오면 그때부터 영역에 씀)
+static inline void takeChar(TokenArena *arena, Lexer *lx, Token *tok) {
+    char c = peekChar(lx, 0);
+    int first = lx->aheadFirst;
+    if (!tok->text) {
+        if (lx->aheadPlain[first] && lx->aheadSource[first] == tok->offset + tok->length) {
+            tok->length++;
+            advanceChar(lx);
+            return;
+        }
+        char *dest = arena->text + arena->textLength;
+        memcpy(dest, lx->line + tok->offset, tok->length);
+        tok->text = dest;
+        arena->textLength += tok->length;
+    }
+    arena->text[arena->textLength++] = c;
+    tok->length++;
+    advanceChar(lx);
+}
+
+// 숫자와 '.'을 모두 토큰에 붙임 (전처리 규칙이 걸리지 않는 글자라 미리 읽은 글자가 없으면 원문을 바로 훑음)
+static void takeDigits(TokenArena *arena, Lexer *lx, Token *tok) {
+    for (;;) {
+        char c = peekChar(lx, 0);
+        if (!isDigit(c) && c != '.') return;
+        takeChar(arena, lx, tok);
+        if (lx->aheadCount == 0 && !tok->text && lx->raw == tok->offset + tok->length &&
+            !(lx->expansion && *lx->expansion)) {
+            const char *line = lx->line;
+            int i = lx->raw;
+            while (i < lx->length && (isDigit(line[i]) || line[i] == '.')) i++;
+            tok->length += i - lx->raw;
+            lx->raw = i;
+        }
+    }
+}
+
+static void finishToken(Lexer *lx, Token *tok) {
+    if (!tok->text) tok->text = lx->line + tok->offset;
+}
+
+// 숫자 토큰을 값으로 바꿈 (strtod가 토큰 전체를 읽지 못하면 0)
+static int finishNumber(TokenArena *arena, Lexer *lx, Token *tok) {
+    finishToken(lx, tok);
+    if ((size_t)tok->length + 1 > arena->numberCapacity) {
+        arena->numberCapacity = (size_t)tok->length + 64;
+        arena->number = realloc(arena->number, arena->numberCapacity);
+    }
+    memcpy(arena->number, tok->text, tok->length);
+    arena->number[tok->length] = '\0';
+    char *end;
+    tok->value = strtod(arena->number, &end);
+    return end != arena->number && end == arena->number + tok->length;
+}
+
+static int isNumberChar(char c) {
+    return isDigit(c) || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+';
+}
+
+// 확장 언어(-x)의 토큰 분리
+// 숫자는 숫자[.숫자][e[+-]숫자]이고 부호를 삼키지 않음 (1+1은 세 토큰), 피연산자 자리의 -는 TOKEN_NEGATE,
+// 이름은 뒤에 (가 오는 표의 함수이면 TOKEN_FUNCTION, 아니면 변수 (변수 모드가 아니면 거부)
+static int lexExtended(TokenArena *arena, Lexer *lx, int variables) {
+    int expectOperand = 1;
+    for (;;) {
+        while (isSpace(peekChar(lx, 0))) advanceChar(lx);
+        char c = peekChar(lx, 0);
+        if (!c) return 1;
+        Token *tok;
+
+        if ((c == '+' || c == '-') && expectOperand) {
+            if (c == '-') addToken(arena, lx, TOKEN_NEGATE);
+            advanceChar(lx);
+        } else if (isalpha((unsigned char)c) || c == '_') {
+            tok = addToken(arena, lx, TOKEN_VARIABLE);
+            while (isIdentifierChar(peekChar(lx, 0))) takeChar(arena, lx, tok);
+            finishToken(lx, tok);
+            while (isSpace(peekChar(lx, 0))) advanceChar(lx);
+            int op = findOperator(tok->text, tok->length);
+            if (op >= 0 && operatorTable[op].kind == OPERATOR_FUNCTION && peekChar(lx, 0) == '(') {
+                tok->kind = TOKEN_FUNCTION;
+                tok->op = (char)op;
+                expectOperand = 1;
+            } else if (variables) {
+                expectOperand = 0;
+            } else {
+                return 0;
+            }
+        } else if (c == '(' || c == ',') {
+            addToken(arena, lx, c == '(' ? TOKEN_OPEN : TOKEN_COMMA);
+            advanceChar(lx);
+            expectOperand = 1;
+        } else if (c == ')') {
+            addToken(arena, lx, TOKEN_CLOSE);
+            advanceChar(lx);
+            expectOperand = 0;
+        } else if (strchr("+-*/^%", c)) {
+            addToken(arena, lx, TOKEN_OPERATOR);
+            advanceChar(lx);
+            expectOperand = 1;
+        } else if (isDigit(c) || c == '.') {
+            tok = addToken(arena, lx, TOKEN_NUMBER);
+            takeDigits(arena, lx, tok);
+            char e = peekChar(lx, 0), sign = peekChar(lx, 1);
+            if ((e == 'e' || e == 'E') &&
+                (isDigit(sign) || ((sign == '+' || sign == '-') && isDigit(peekChar(lx, 2))))) {
+                takeChar(arena, lx, tok);
+                if (!isDigit(sign)) takeChar(arena, lx, tok);
+                while (isDigit(peekChar(lx, 0))) takeChar(arena, lx, tok);
+            }
+            if (!finishNumber(arena, lx, tok)) return 0;
+            expectOperand = 0;
+        } else {
+            return 0;
+        }
+    }
+}
+
+// 원문 [line, line + length)를 토큰으로 나눔 (NUL이 있으면 거기까지)
+// 토큰 경계는 preprocess_line 후 tokenize와 같고 (괄호 안 음수, 단항 부호, 숫자 안의 +/- 포함 등)
+// 다만 토큰 길이와 개수에 한계가 없음 (tokenize는 63글자가 넘는 숫자를 잘라 두 토큰으로 만듦)
+// tokenize가 거부하거나 strtod가 읽지 못하는 숫자가 있으면 0
+// flags에 LEX_VARIABLES가 있으면 변수 이름을 TOKEN_VARIABLE로, 피연산자 자리의 -이름은 TOKEN_NEGATE와 이름으로 나눔
+// LEX_EXTENDED가 있으면 lexExtended의 규칙을 씀
+int lexExpression(TokenArena *arena, const char *line, size_t length, int flags) {
+    int variables = flags & LEX_VARIABLES;
+    Lexer lx;
+    memset(&lx, 0, sizeof(lx));
+    lx.line = line;
+    lx.length = (int)strnlen(line, length);
+    lx.variables = variables || (flags & LEX_EXTENDED);
+    lx.extended = (flags & LEX_EXTENDED) != 0;
+
+    // 치환으로 늘어나는 글자는 원문 한 글자당 최대 9글자 (e → 2.7182818)
+    size_t textNeeded = (size_t)lx.length * 9 + 1;
+    if (textNeeded > arena->textCapacity) {
+        arena->textCapacity = textNeeded;
+        free(arena->text);
+        arena->text = malloc(textNeeded);
+    }
+    arena->textLength = 0;
+    arena->count = 0;
+    arena->flags = flags;
+    if (lx.extended) return lexExtended(arena, &lx, variables);
+
+    int expectOperand = 1; // 줄 처음이거나 직전 토큰이 연산자나 '('이면 부호는 숫자의 일부
+    for (;;) {
+        while (isSpace(peekChar(&lx, 0))) advanceChar(&lx);
+        char c = peekChar(&lx, 0);
+        if (!c) break;
+        char next = peekChar(&lx, 1);
+        Token *tok;
+
+        // 괄호 안 음수 처리: (-1.0) → 하나의 숫자
+        if (c == '(' && (next == '-' || next == '+') &&
+            (isDigit(peekChar(&lx, 2)) || peekChar(&lx, 2) == '.')) {
+            advanceChar(&lx);
+            tok = addToken(arena, &lx, TOKEN_NUMBER);
+            takeChar(arena, &lx, tok);
+            do {
+                takeDigits(arena, &lx, tok);
+                if (isNumberChar(peekChar(&lx, 0))) takeChar(arena, &lx, tok);
+            } while (isNumberChar(peekChar(&lx, 0)));
+            if (!finishNumber(arena, &lx, tok)) return 0;
+            if (peekChar(&lx, 0) == ')') advanceChar(&lx);
+            expectOperand = 0;
+            continue;
+        }
+
+        // 단항 연산자 위치에서 -3.5e0 인식 (부호만 있으면 이항 연산자로 취급됨)
+        if ((c == '+' || c == '-') && expectOperand) {
+            if (isDigit(next) || next == '.' || next == 'e' || next == 'E') {
+                tok = addToken(arena, &lx, TOKEN_NUMBER);
+                takeChar(arena, &lx, tok);
+                takeDigits(arena, &lx, tok);
+                if (peekChar(&lx, 0) == 'e' || peekChar(&lx, 0) == 'E') {
+                    takeChar(arena, &lx, tok);
+                    if (peekChar(&lx, 0) == '-' || peekChar(&lx, 0) == '+') takeChar(arena, &lx, tok);
+                    while (isDigit(peekChar(&lx, 0))) takeChar(arena, &lx, tok);
+                }
+                if (!finishNumber(arena, &lx, tok)) return 0;
+                expectOperand = 0;
+                continue;
+            }
+
+            // 변수 앞의 단항 부호: -x는 -1 * x, +x는 x
+            if (variables && (isalpha((unsigned char)next) || next == '_')) {
+                if (c == '-') addToken(arena, &lx, TOKEN_NEGATE);
+                advanceChar(&lx);
+                continue;
+            }
+        }
+
+        if (variables && (isalpha((unsigned char)c) || c == '_')) {
+            tok = addToken(arena, &lx, TOKEN_VARIABLE);
+            while (isIdentifierChar(peekChar(&lx, 0))) takeChar(arena, &lx, tok);
+            finishToken(&lx, tok);
+            expectOperand = 0;
+        } else if (c == '(') {
+            addToken(arena, &lx, TOKEN_OPEN);
+            advanceChar(&lx);
+            expectOperand = 1;
+        } else if (c == ')') {
+            addToken(arena, &lx, TOKEN_CLOSE);
+            advanceChar(&lx);
+            expectOperand = 0;
+        } else if (strchr("+-*/^", c)) {
+            addToken(arena, &lx, TOKEN_OPERATOR);
+            advanceChar(&lx);
+            expectOperand = 1;
+        } else if (isDigit(c) || c == '.') {
+            tok = addToken(arena, &lx, TOKEN_NUMBER);
+            do {
+                takeDigits(arena, &lx, tok);
+                if (isNumberChar(peekChar(&lx, 0))) takeChar(arena, &lx, tok);
+            } while (isNumberChar(peekChar(&lx, 0)));
+            if (!finishNumber(arena, &lx, tok)) return 0;
+            expectOperand = 0;
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 수식에 나온 변수 이름 (나온 순서대로 번호를 매김)
+#define MAX_VARIABLES 64
+
+typedef struct {
+    int count;
+    char names[MAX_VARIABLES][MAX_TOKEN_LEN];
+} VariableTable;
+
+void initVariableTable(VariableTable *vars) { vars->count = 0; }
+
+// 이름의 변수 번호 (처음 보는 이름이면 추가, 이름이 너무 길거나 자리가 없으면 -1)
+int findVariable(VariableTable *vars, const char *name, int len) {
+    if (len >= MAX_TOKEN_LEN) return -1;
+    for (int i = 0; i < vars->count; i++) {
+        if ((int)strlen(vars->names[i]) == len && !memcmp(vars->names[i], name, len)) return i;
+    }
+    if (vars->count == MAX_VARIABLES) return -1;
+    memcpy(vars->names[vars->count], name, len);
+    vars->names[vars->count][len] = '\0';
+    return vars->count++;
+}
+
+// 한 줄을 컴파일한 결과
+// 배열은 줄마다 다시 쓰며 토큰 수에 맞춰 늘어남 (명령 수는 토큰 수의 두 배를 넘지 않음)
+typedef struct {
+    TokenArena tokens;              // 상수 원문이 들어 있는 토큰 기록
+    int length;                     // 명령 수
+    int constantCount;
+    int variableCount;              // OP_VAR 명령 수
+    int stackValid;                 // 실행 중 피연산자가 모자라지 않고 끝에 값이 하나 남는지
+    int maxDepth;                   // 실행 중 스택의 최대 깊이
+    int capacity;                   // 아래 배열의 크기
+    unsigned char *code;
+    double *constants;              // OP_PUSH가 차례로 꺼내 쓰는 미리 변환된 값
+    const char **constantText;      // Postfix 출력용 상수 원문과 길이 (NULL이면 원문 없이 만든 상수)
+    int *constantLength;
+    unsigned char *variables;       // OP_VAR가 차례로 꺼내 쓰는 변수 번호
+    unsigned char *operators;       // 컴파일 중 연산자 스택 (opcode 또는 '(')
+    int *arguments;                 // 연산자 스택의 '(' 자리마다 지금까지 센 인자 수
+    double *stack;                  // 실행용 스택
+} Program;
+
+void initProgram(Program *prog) {
+    memset(prog, 0, sizeof(*prog));
+    initTokenArena(&prog->tokens);
+}
+
+void freeProgram(Program *prog) {
+    freeTokenArena(&prog->tokens);
+    free(prog->code);
+    free(prog->constants);
+    free(prog->constantText);
+    free(prog->constantLength);
+    free(prog->variables);
+    free(prog->operators);
+    free(prog->arguments);
+    free(prog->stack);
+    initProgram(prog);
+}
+
+static void reserveProgram(Program *prog, int capacity) {
+    if (capacity <= prog->capacity) return;
+    if (capacity < 2 * prog->capacity) capacity = 2 * prog->capacity;
+    prog->capacity = capacity;
+    prog->code = realloc(prog->code, capacity);
+    prog->constants = realloc(prog->constants, capacity * sizeof(double));
+    prog->constantText = realloc(prog->constantText, capacity * sizeof(const char *));
+    prog->constantLength = realloc(prog->constantLength, capacity * sizeof(int));
+    prog->variables = realloc(prog->variables, capacity);
+    prog->operators = realloc(prog->operators, capacity);
+    prog->arguments = realloc(prog->arguments, capacity * sizeof(int));
+    prog->stack = realloc(prog->stack, capacity * sizeof(double));
+}
+
+// 스택 깊이를 따라가며 명령 하나를 추가 (피연산자 수는 operatorTable에서)
+static void emitOperator(Program *prog, unsigned char op, int *depth) {
+    int arity = operatorTable[op].arity;
+    prog->code[prog->length++] = op;
+    if (*depth < arity) prog->stackValid = 0;
+    else *depth -= arity - 1;
+}
+
+// 피연산자 하나를 올릴 때의 스택 깊이 갱신
+static void pushOperand(Program *prog, int *depth) {
+    if (++*depth > prog->maxDepth) prog->maxDepth = *depth;
+}
+
+// 상수 하나를 추가 (text가 NULL이면 원문 없이 만든 상수)
+static void emitConstant(Program *prog, double value, const char *text, int len, int *depth) {
+    prog->code[prog->length++] = OP_PUSH;
+    prog->constants[prog->constantCount] = value;
+    prog->constantText[prog->constantCount] = text;
+    prog->constantLength[prog->constantCount] = len;
+    prog->constantCount++;
+    pushOperand(prog, depth);
+}
+
+// prog->tokens의 토큰열을 차량기지(shunting-yard) 알고리즘으로 명령열로 만듦
+// 괄호가 맞지 않거나 변수를 더 둘 자리가 없으면 0
+// 확장 언어 토큰열이면 단항 -는 접두 연산자 OP_NEG, 함수는 닫는 괄호에서 인자 수를 확인해 내보내고
+// ^처럼 오른쪽 결합인 연산자는 우선순위가 같은 앞 연산자를 꺼내지 않음
+int compileTokens(Program *prog, VariableTable *vars) {
+    const Token *tokens = prog->tokens.tokens;
+    int count = prog->tokens.count;
+    reserveProgram(prog, 2 * count + 1);
+    unsigned char *opStack = prog->operators;
+    int *arguments = prog->arguments;
+    int opTop = 0;
+    int depth = 0;
+    int extended = prog->tokens.flags & LEX_EXTENDED;
+
+    prog->length = 0;
+    prog->constantCount = 0;
+    prog->variableCount = 0;
+    prog->stackValid = 1;
+    prog->maxDepth = 0;
+
+    for (int i = 0; i < count; i++) {
+        const Token *tok = &tokens[i];
+        switch (tok->kind) {
+        case TOKEN_NUMBER:
+            emitConstant(prog, tok->value, tok->text, tok->length, &depth);
+            break;
+        case TOKEN_NEGATE:
+            if (extended) {
+                opStack[opTop++] = OP_NEG;
+                break;
+            }
+            emitConstant(prog, -1, NULL, 0, &depth);
+            opStack[opTop++] = OP_MUL;
+            break;
+        case TOKEN_FUNCTION:
+            opStack[opTop++] = (unsigned char)tok->op;
+            break;
+        case TOKEN_COMMA:
+            while (opTop > 0 && opStack[opTop - 1] != '(') {
+                emitOperator(prog, opStack[--opTop], &depth);
+            }
+            if (opTop < 2 || operatorTable[opStack[opTop - 2]].kind != OPERATOR_FUNCTION) return 0;
+            arguments[opTop - 1]++;
+            break;
+        case TOKEN_VARIABLE: {
+            int index = findVariable(vars, tok->text, tok->length);
+            if (index < 0) return 0;
+            prog->code[prog->length++] = OP_VAR;
+            prog->variables[prog->variableCount++] = (unsigned char)index;
+            pushOperand(prog, &depth);
+            break;
+        }
+        case TOKEN_OPEN:
+            arguments[opTop] = 1;
+            opStack[opTop++] = '(';
+            break;
+        case TOKEN_CLOSE:
+            while (opTop > 0 && opStack[opTop - 1] != '(') {
+                emitOperator(prog, opStack[--opTop], &depth);
+            }
+            if (opTop == 0) return 0;
+            opTop--;
+            if (opTop > 0 && opStack[opTop - 1] != '(' &&
+                operatorTable[opStack[opTop - 1]].kind == OPERATOR_FUNCTION) {
+                if (arguments[opTop] != operatorTable[opStack[opTop - 1]].arity) return 0;
+                emitOperator(prog, opStack[--opTop], &depth);
+            }
+            break;
+        case TOKEN_OPERATOR: {
+            char name = tok->op;
+            unsigned char op = (unsigned char)findOperator(&name, 1);
+            int precedence = operatorTable[op].precedence;
+            int right = extended && operatorTable[op].rightAssociative;
+            while (opTop > 0 && opStack[opTop - 1] != '(' &&
+                   (operatorTable[opStack[opTop - 1]].precedence > precedence ||
+                    (operatorTable[opStack[opTop - 1]].precedence == precedence && !right))) {
+                emitOperator(prog, opStack[--opTop], &depth);
+            }
+            opStack[opTop++] = op;
+            break;
+        }
+        }
+    }
+
+    while (opTop > 0) {
+        if (opStack[opTop - 1] == '(') return 0;
+        emitOperator(prog, opStack[--opTop], &depth);
+    }
+    if (depth != 1) prog->stackValid = 0;
+    return prog->length > 0;
+}
+
+// 원문 [line, line + length)를 토큰으로 나눠 컴파일 (tokenize/toPostfix가 거부했을 줄이면 0)
+// vars가 NULL이 아니면 변수 이름을 OP_VAR로 바꾸고, 피연산자 자리의 -이름은 -1 * 이름으로 처리
+// (extendedLanguage이면 확장 언어로 읽음)
+int compileExpression(const char *line, size_t length, Program *prog, VariableTable *vars) {
+    int flags = (vars ? LEX_VARIABLES : 0) | (extendedLanguage ? LEX_EXTENDED : 0);
+    if (!lexExpression(&prog->tokens, line, length, flags)) return 0;
+    return compileTokens(prog, vars);
+}
+
+// 정수 지수 빠른 경로: 지수가 0..POW_MAX_EXPONENT 정수이면 제곱-곱셈으로 계산하고
+// 곱셈마다 FMA로 반올림 오차(a * b - fl(a * b))가 0인지 확인함
+// 모든 곱셈이 정확하면 결과가 참값 그대로이므로 pow(1 ULP 미만 오차)와 같은 값이 되고,
+// 하나라도 반올림이 생기면 pow로 다시 계산함
+// 오차 항이 언더플로되지 않도록 곱의 절댓값이 POW_EXACT_MIN 이상일 때만 정확하다고 봄
+#define POW_MAX_EXPONENT 63
+#define POW_EXACT_MIN 0x1p-969
+
+static inline int isExactProduct(double x, double y, double product) {
+    double magnitude = fabs(product);
+    return fma(x, y, -product) == 0 && magnitude >= POW_EXACT_MIN && magnitude <= DBL_MAX;
+}
+
+double integerPower(double x, int n) {
+    double magnitude = fabs(x);
+    if (magnitude < POW_EXACT_MIN || magnitude > DBL_MAX) return pow(x, n);
+
+    double result = 1, base = x;
+    for (int e = n; ; ) {
+        if (e & 1) {
+            double product = result * base;
+            if (!isExactProduct(result, base, product)) return pow(x, n);
+            result = product;
+        }
+        e >>= 1;
+        if (!e) break;
+        double square = base * base;
+        if (!isExactProduct(base, base, square)) return pow(x, n);
+        base = square;
+    }
+    return result;
+}
+
+// 확장 언어의 연산 (y는 이항 연산일 때만 씀, 0으로 나누는 %는 부르는 쪽에서 거름)
+static double applyExtended(unsigned char op, double x, double y) {
+    switch (op) {
+    case OP_MOD: return fmod(x, y);
+    case OP_SQRT: return sqrt(x);
+    case OP_SIN: return sin(x);
+    case OP_COS: return cos(x);
+    case OP_TAN: return tan(x);
+    case OP_LOG: return log(x);
+    case OP_EXP: return exp(x);
+    case OP_ABS: return fabs(x);
+    case OP_MIN: return fmin(x, y);
+    case OP_MAX: return fmax(x, y);
+    default: return x;
+    }
+}
+
+// 바이트코드 실행 (스택 검사는 컴파일할 때 끝났으므로 0으로 나누기만 확인)
+// values[i]는 i번 변수의 값 (변수가 없는 수식이면 NULL)
+int runProgram(Program *prog, const double *values, double *result) {
+    if (!prog->stackValid) return 0;
+
+    const unsigned char *code = prog->code;
+    const unsigned char *codeEnd = code + prog->length;
+    const double *constant = prog->constants;
+    const unsigned char *variable = prog->variables;
+    double *sp = prog->stack; // 다음에 쓸 칸
+
+    while (code < codeEnd) {
+        switch (*code++) {
+        case OP_PUSH:
+            *sp++ = *constant++;
+            break;
+        case OP_ADD:
+            sp--;
+            sp[-1] = sp[-1] + sp[0];
+            break;
+        case OP_SUB:
+            sp--;
+            sp[-1] = sp[-1] - sp[0];
+            break;
+        case OP_MUL:
+            sp--;
+            sp[-1] = sp[-1] * sp[0];
+            break;
+        case OP_DIV:
+            sp--;
+            if (sp[0] == 0) return 0;
+            sp[-1] = sp[-1] / sp[0];
+            break;
+        case OP_POW:
+            sp--;
+            sp[-1] = pow(sp[-1], sp[0]);
+            break;
+        case OP_VAR:
+            *sp++ = values[*variable++];
+            break;
+        case OP_NEG:
+            // NaN은 -1을 곱할 때처럼 부호를 그대로 둠
+            if (sp[-1] == sp[-1]) sp[-1] = -sp[-1];
+            break;
+        case OP_SQR:
+            sp[-1] = integerPower(sp[-1], 2);
+            break;
+        case OP_POWI:
+            sp[-1] = integerPower(sp[-1], (int)*constant++);
+            break;
+        default: {
+            unsigned char op = code[-1];
+            if (operatorTable[op].arity == 2) {
+                sp--;
+                if (op == OP_MOD && sp[0] == 0) return 0;
+                sp[-1] = applyExtended(op, sp[-1], sp[0]);
+            } else {
+                sp[-1] = applyExtended(op, sp[-1], 0);
+            }
+            break;
+        }
+        }
+    }
+
+    *result = prog->stack[0];
+    return 1;
+}
+
+// 블록 연산 커널: a[r] = a[r] 연산 b[r] (r < n)
+// 실행 중인 CPU에 맞춰 스칼라/AVX2/AVX-512 중 하나를 고르며 어느 쪽이든 결과는 비트 단위로 같음
+// (+ - * /는 IEEE 연산이라 폭과 상관없이 같고, ^는 아래 정수 지수 빠른 경로 참고)
+typedef struct {
+    const char *name;
+    void (*add)(double *a, const double *b, int n);
+    void (*sub)(double *a, const double *b, int n);
+    void (*mul)(double *a, const double *b, int n);
+    void (*div)(double *a, const double *b, unsigned char *valid, int n); // 0으로 나눈 행은 valid = 0
+    void (*pow)(double *a, const double *b, int n);
+} BlockKernels;
+
+static void addScalar(double *a, const double *b, int n) {
+    for (int r = 0; r < n; r++) a[r] = a[r] + b[r];
+}
+
+static void subScalar(double *a, const double *b, int n) {
+    for (int r = 0; r < n; r++) a[r] = a[r] - b[r];
+}
+
+static void mulScalar(double *a, const double *b, int n) {
+    for (int r = 0; r < n; r++) a[r] = a[r] * b[r];
+}
+
+static void divScalar(double *a, const double *b, unsigned char *valid, int n) {
+    for (int r = 0; r < n; r++) {
+        valid[r] &= b[r] != 0;
+        a[r] = a[r] / b[r];
+    }
+}
+
+static void powScalar(double *a, const double *b, int n) {
+    for (int r = 0; r < n; r++) a[r] = pow(a[r], b[r]);
+}
+
+static const BlockKernels scalarKernels = {
+    "scalar", addScalar, subScalar, mulScalar, divScalar, powScalar
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+// ^ 커널은 integerPower와 같은 정수 지수 빠른 경로를 칸마다 함께 진행하고,
+// 곱셈 하나라도 반올림이 생긴 칸만 스칼라 pow로 다시 계산함
+
+__attribute__((target("avx2,fma")))
+static void addAvx2(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        _mm256_storeu_pd(a + r, _mm256_add_pd(_mm256_loadu_pd(a + r), _mm256_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] + b[r];
+}
+
+__attribute__((target("avx2,fma")))
+static void subAvx2(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        _mm256_storeu_pd(a + r, _mm256_sub_pd(_mm256_loadu_pd(a + r), _mm256_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] - b[r];
+}
+
+__attribute__((target("avx2,fma")))
+static void mulAvx2(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        _mm256_storeu_pd(a + r, _mm256_mul_pd(_mm256_loadu_pd(a + r), _mm256_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] * b[r];
+}
+
+__attribute__((target("avx2,fma")))
+static void divAvx2(double *a, const double *b, unsigned char *valid, int n) {
+    const __m256d zero = _mm256_setzero_pd();
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        __m256d vb = _mm256_loadu_pd(b + r);
+        int zeroMask = _mm256_movemask_pd(_mm256_cmp_pd(vb, zero, _CMP_EQ_OQ));
+        _mm256_storeu_pd(a + r, _mm256_div_pd(_mm256_loadu_pd(a + r), vb));
+        for (int k = 0; zeroMask; k++, zeroMask >>= 1) {
+            if (zeroMask & 1) valid[r + k] = 0;
+        }
+    }
+    divScalar(a + r, b + r, valid + r, n - r);
+}
+
+// 곱이 정확한 칸의 마스크 (오차가 0이고 곱이 유한하며 너무 작지 않음)
+__attribute__((target("avx2,fma")))
+static inline __m256d exactProductAvx2(__m256d x, __m256d y, __m256d product) {
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    __m256d magnitude = _mm256_and_pd(product, absMask);
+    __m256d error = _mm256_fmsub_pd(x, y, product);
+    return _mm256_and_pd(_mm256_cmp_pd(error, _mm256_setzero_pd(), _CMP_EQ_OQ),
+                         _mm256_and_pd(_mm256_cmp_pd(magnitude, _mm256_set1_pd(POW_EXACT_MIN), _CMP_GE_OQ),
+                                       _mm256_cmp_pd(magnitude, _mm256_set1_pd(DBL_MAX), _CMP_LE_OQ)));
+}
+
+__attribute__((target("avx2,fma")))
+static void powAvx2(double *a, const double *b, int n) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    int r = 0;
+    for (; r + 4 <= n; r += 4) {
+        __m256d x = _mm256_loadu_pd(a + r);
+        __m256d y = _mm256_loadu_pd(b + r);
+        __m256d magnitude = _mm256_and_pd(x, absMask);
+        __m256d ok = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(y, _mm256_round_pd(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), _CMP_EQ_OQ),
+                          _mm256_cmp_pd(y, zero, _CMP_GE_OQ)),
+            _mm256_and_pd(_mm256_cmp_pd(y, _mm256_set1_pd(POW_MAX_EXPONENT), _CMP_LE_OQ),
+                          _mm256_and_pd(_mm256_cmp_pd(magnitude, _mm256_set1_pd(POW_EXACT_MIN), _CMP_GE_OQ),
+                                        _mm256_cmp_pd(magnitude, _mm256_set1_pd(DBL_MAX), _CMP_LE_OQ))));
+        int okMask = _mm256_movemask_pd(ok);
+        double bases[4], exponents[4];
+        _mm256_storeu_pd(bases, x);
+        _mm256_storeu_pd(exponents, y);
+        if (okMask) {
+            __m256i exponent = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(_mm256_and_pd(y, ok)));
+            __m256d result = one, base = x;
+            for (int bit = 0; ; bit++) {
+                __m256i mask = _mm256_set1_epi64x(1LL << bit);
+                __m256d use = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(exponent, mask), mask));
+                __m256d product = _mm256_mul_pd(result, base);
+                ok = _mm256_andnot_pd(_mm256_andnot_pd(exactProductAvx2(result, base, product), use), ok);
+                result = _mm256_blendv_pd(result, product, use);
+
+                // 더 높은 비트가 남은 칸이 없으면 끝
+                __m256i rest = _mm256_srli_epi64(exponent, bit + 1);
+                __m256d more = _mm256_castsi256_pd(_mm256_cmpgt_epi64(rest, _mm256_setzero_si256()));
+                if (!_mm256_movemask_pd(_mm256_and_pd(more, ok))) break;
+                __m256d square = _mm256_mul_pd(base, base);
+                ok = _mm256_andnot_pd(_mm256_andnot_pd(exactProductAvx2(base, base, square), more), ok);
+                base = square;
+            }
+            _mm256_storeu_pd(a + r, result);
+            okMask = _mm256_movemask_pd(ok);
+        }
+        for (int k = 0; k < 4; k++) {
+            if (!(okMask >> k & 1)) a[r + k] = pow(bases[k], exponents[k]);
+        }
+    }
+    powScalar(a + r, b + r, n - r);
+}
+
+static const BlockKernels avx2Kernels = {
+    "avx2", addAvx2, subAvx2, mulAvx2, divAvx2, powAvx2
+};
+
+__attribute__((target("avx512f")))
+static void addAvx512(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 8 <= n; r += 8) {
+        _mm512_storeu_pd(a + r, _mm512_add_pd(_mm512_loadu_pd(a + r), _mm512_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] + b[r];
+}
+
+__attribute__((target("avx512f")))
+static void subAvx512(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 8 <= n; r += 8) {
+        _mm512_storeu_pd(a + r, _mm512_sub_pd(_mm512_loadu_pd(a + r), _mm512_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] - b[r];
+}
+
+__attribute__((target("avx512f")))
+static void mulAvx512(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 8 <= n; r += 8) {
+        _mm512_storeu_pd(a + r, _mm512_mul_pd(_mm512_loadu_pd(a + r), _mm512_loadu_pd(b + r)));
+    }
+    for (; r < n; r++) a[r] = a[r] * b[r];
+}
+
+__attribute__((target("avx512f")))
+static void divAvx512(double *a, const double *b, unsigned char *valid, int n) {
+    int r = 0;
+    for (; r + 8 <= n; r += 8) {
+        __m512d vb = _mm512_loadu_pd(b + r);
+        unsigned zeroMask = _mm512_cmp_pd_mask(vb, _mm512_setzero_pd(), _CMP_EQ_OQ);
+        _mm512_storeu_pd(a + r, _mm512_div_pd(_mm512_loadu_pd(a + r), vb));
+        for (int k = 0; zeroMask; k++, zeroMask >>= 1) {
+            if (zeroMask & 1) valid[r + k] = 0;
+        }
+    }
+    divScalar(a + r, b + r, valid + r, n - r);
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask8 exactProductAvx512(__m512d x, __m512d y, __m512d product) {
+    __m512d magnitude = _mm512_abs_pd(product);
+    __m512d error = _mm512_fmsub_pd(x, y, product);
+    return _mm512_cmp_pd_mask(error, _mm512_setzero_pd(), _CMP_EQ_OQ) &
+           _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(POW_EXACT_MIN), _CMP_GE_OQ) &
+           _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(DBL_MAX), _CMP_LE_OQ);
+}
+
+__attribute__((target("avx512f")))
+static void powAvx512(double *a, const double *b, int n) {
+    int r = 0;
+    for (; r + 8 <= n; r += 8) {
+        __m512d x = _mm512_loadu_pd(a + r);
+        __m512d y = _mm512_loadu_pd(b + r);
+        __m512d magnitude = _mm512_abs_pd(x);
+        __mmask8 ok = _mm512_cmp_pd_mask(y, _mm512_roundscale_pd(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC), _CMP_EQ_OQ) &
+                      _mm512_cmp_pd_mask(y, _mm512_setzero_pd(), _CMP_GE_OQ) &
+                      _mm512_cmp_pd_mask(y, _mm512_set1_pd(POW_MAX_EXPONENT), _CMP_LE_OQ) &
+                      _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(POW_EXACT_MIN), _CMP_GE_OQ) &
+                      _mm512_cmp_pd_mask(magnitude, _mm512_set1_pd(DBL_MAX), _CMP_LE_OQ);
+        double bases[8], exponents[8];
+        _mm512_storeu_pd(bases, x);
+        _mm512_storeu_pd(exponents, y);
+        if (ok) {
+            __m512i exponent = _mm512_cvtepi32_epi64(_mm512_cvttpd_epi32(_mm512_maskz_mov_pd(ok, y)));
+            __m512d result = _mm512_set1_pd(1.0), base = x;
+            for (int bit = 0; ; bit++) {
+                __mmask8 use = _mm512_test_epi64_mask(exponent, _mm512_set1_epi64(1LL << bit));
+                __m512d product = _mm512_mul_pd(result, base);
+                ok &= ~(use & ~exactProductAvx512(result, base, product));
+                result = _mm512_mask_blend_pd(use, result, product);
+
+                __mmask8 more = _mm512_cmpgt_epi64_mask(_mm512_srli_epi64(exponent, bit + 1), _mm512_setzero_si512());
+                if (!(more & ok)) break;
+                __m512d square = _mm512_mul_pd(base, base);
+                ok &= ~(more & ~exactProductAvx512(base, base, square));
+                base = square;
+            }
+            _mm512_storeu_pd(a + r, result);
+        }
+        for (int k = 0; k < 8; k++) {
+            if (!(ok >> k & 1)) a[r + k] = pow(bases[k], exponents[k]);
+        }
+    }
+    powScalar(a + r, b + r, n - r);
+}
+
+static const BlockKernels avx512Kernels = {
+    "avx512", addAvx512, subAvx512, mulAvx512, divAvx512, powAvx512
+};
+#endif
+
+// 블록 실행에 쓸 커널 (main에서 selectBlockKernels로 고름)
+static const BlockKernels *blockKernels = &scalarKernels;
+
+// name이 NULL이면 CPU가 지원하는 가장 넓은 커널, 아니면 그 이름의 커널을 고름 (없으면 0)
+int selectBlockKernels(const char *name) {
+    const BlockKernels *candidates[3];
+    int count = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) candidates[count++] = &avx512Kernels;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) candidates[count++] = &avx2Kernels;
+#endif
+    candidates[count++] = &scalarKernels;
+
+    for (int i = 0; i < count; i++) {
+        if (!name || !strcmp(name, candidates[i]->name)) {
+            blockKernels = candidates[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 여러 행을 한 번에 실행 (행 단위 대신 명령마다 count개 값을 blockKernels 한 번으로 계산)
+// columns[i][r]은 r번 행의 i번 변수 값, stack은 (maxDepth + 1) * count개 이상
+// valid[r]은 0으로 나누기가 없었으면 1, results[r]에 결과를 씀
+void runProgramBlock(const Program *prog, const double *const *columns, int count,
+                     double *stack, double *results, unsigned char *valid) {
+    const double *constant = prog->constants;
+    const unsigned char *variable = prog->variables;
+    double *top = stack - count; // 맨 위 값의 시작 (count개 단위로 쌓음)
+
+    for (int r = 0; r < count; r++) valid[r] = prog->stackValid;
+    if (!prog->stackValid) return;
+
+    for (int i = 0; i < prog->length; i++) {
+        double *a = top - count;
+        double *b = top;
+        switch (prog->code[i]) {
+        case OP_PUSH: {
+            double value = *constant++;
+            top += count;
+            for (int r = 0; r < count; r++) top[r] = value;
+            break;
+        }
+        case OP_VAR:
+            top += count;
+            memcpy(top, columns[*variable++], count * sizeof(double));
+            break;
+        case OP_ADD:
+            blockKernels->add(a, b, count);
+            top = a;
+            break;
+        case OP_SUB:
+            blockKernels->sub(a, b, count);
+            top = a;
+            break;
+        case OP_MUL:
+            blockKernels->mul(a, b, count);
+            top = a;
+            break;
+        case OP_DIV:
+            blockKernels->div(a, b, valid, count);
+            top = a;
+            break;
+        case OP_POW:
+            blockKernels->pow(a, b, count);
+            top = a;
+            break;
+        case OP_NEG:
+            for (int r = 0; r < count; r++) {
+                if (b[r] == b[r]) b[r] = -b[r];
+            }
+            break;
+        case OP_SQR:
+        case OP_POWI: {
+            // 지수를 맨 위 다음 칸에 채워 ^ 커널로 계산 (stack은 maxDepth + 1칸)
+            double exponent = prog->code[i] == OP_SQR ? 2 : *constant++;
+            double *e = top + count;
+            for (int r = 0; r < count; r++) e[r] = exponent;
+            blockKernels->pow(b, e, count);
+            break;
+        }
+        default: {
+            // 확장 언어의 연산은 커널 없이 행마다 계산
+            unsigned char op = prog->code[i];
+            if (operatorTable[op].arity == 2) {
+                for (int r = 0; r < count; r++) {
+                    if (op == OP_MOD && b[r] == 0) valid[r] = 0;
+                    else a[r] = applyExtended(op, a[r], b[r]);
+                }
+                top = a;
+            } else {
+                for (int r = 0; r < count; r++) b[r] = applyExtended(op, b[r], 0);
+            }
+            break;
+        }
+        }
+    }
+
+    memcpy(results, stack, count * sizeof(double));
+}
+
+// 최적화기: 명령열을 식 트리로 되돌려 상수 부분식을 미리 계산하고, -1 * x를 OP_NEG로,
+// 작은 정수 거듭제곱을 OP_SQR/OP_POWI로 바꾼 뒤 다시 명령열로 만듦
+// 모든 변환은 원래 명령열과 비트 단위로 같은 결과를 냄 (0으로 나누는 상수 나눗셈은 그대로 둠)
+typedef struct {
+    unsigned char op;
+    int left, right; // 자식 노드 번호 (단항 연산은 left만)
+    int variable;    // OP_VAR의 변수 번호
+    double value;     // OP_PUSH의 상수, OP_POWI의 지수
+    const char *text; // OP_PUSH 상수의 원문과 길이
+    int len;
+} ExprNode;
+
+typedef struct {
+    ExprNode *nodes;
+    int *work;          // 트리를 만들고 다시 쓸 때의 노드 스택
+    int capacity;       // nodes 크기 (work는 두 배)
+    long long before;   // 최적화 전 명령 수 합계
+    long long after;    // 최적화 후 명령 수 합계
+    long long folded;   // 미리 계산한 연산 수
+    long long negated;  // -1 * x를 OP_NEG로 바꾼 수
+    long long powers;   // 거듭제곱을 OP_SQR/OP_POWI로 바꾼 수
+} Optimizer;
+
+void initOptimizer(Optimizer *opt) {
+    opt->nodes = NULL;
+    opt->work = NULL;
+    opt->capacity = 0;
+    opt->before = opt->after = 0;
+    opt->folded = opt->negated = opt->powers = 0;
+}
+
+void freeOptimizer(Optimizer *opt) {
+    free(opt->nodes);
+    free(opt->work);
+    opt->nodes = NULL;
+    opt->work = NULL;
+    opt->capacity = 0;
+}
+
+static int isConstantNode(const ExprNode *node, double value) {
+    return node->op == OP_PUSH && node->value == value;
+}
+
+// 새 연산 노드를 만들면서 바로 줄임 (자식은 이미 최적화되어 있음, 단항 연산이면 right는 -1)
+static int optimizeNode(Optimizer *opt, int count, unsigned char op, int left, int right) {
+    ExprNode *nodes = opt->nodes;
+    ExprNode *a = &nodes[left];
+    ExprNode *node = &nodes[count];
+    node->op = op;
+    node->left = left;
+    node->right = right;
+    if (right < 0) {
+        // 단항 연산 (확장 언어의 단항 -와 함수)
+        if (a->op == OP_PUSH) {
+            double x = a->value;
+            node->op = OP_PUSH;
+            node->value = op == OP_NEG ? (x == x ? -x : x) : applyExtended(op, x, 0);
+            node->text = NULL;
+            opt->folded++;
+        }
+        return count;
+    }
+    ExprNode *b = &nodes[right];
+
+    // 상수끼리의 연산은 실행할 때와 같은 식으로 미리 계산
+    if (a->op == OP_PUSH && b->op == OP_PUSH && !((op == OP_DIV || op == OP_MOD) && b->value == 0)) {
+        double value = 0;
+        switch (op) {
+        case OP_ADD: value = a->value + b->value; break;
+        case OP_SUB: value = a->value - b->value; break;
+        case OP_MUL: value = a->value * b->value; break;
+        case OP_DIV: value = a->value / b->value; break;
+        case OP_POW: value = pow(a->value, b->value); break;
+        default: value = applyExtended(op, a->value, b->value); break;
+        }
+        node->op = OP_PUSH;
+        node->value = value;
+        node->text = NULL;
+        opt->folded++;
+    }
+    // -1 * x, x * -1 → neg x
+    else if (op == OP_MUL && (isConstantNode(a, -1) || isConstantNode(b, -1))) {
+        node->op = OP_NEG;
+        node->left = isConstantNode(a, -1) ? right : left;
+        opt->negated++;
+    }
+    // x ^ n (n은 0..POW_MAX_EXPONENT 정수) → sqr x 또는 powi x n
+    else if (op == OP_POW && b->op == OP_PUSH && b->value >= 0 && b->value <= POW_MAX_EXPONENT &&
+             b->value == (int)b->value) {
+        node->op = b->value == 2 ? OP_SQR : OP_POWI;
+        node->value = b->value;
+        opt->powers++;
+    }
+    return count;
+}
+
+// 노드를 후위 순서로 다시 명령열에 씀
+// 줄 길이에 한계가 없어 트리가 아주 깊을 수 있으므로 재귀 대신 work를 스택으로 씀
+// (항목 = 노드 번호 * 2, 자식을 다 쓴 뒤 연산을 쓸 차례이면 + 1)
+static void emitNodes(Program *prog, const ExprNode *nodes, int root, int *work) {
+    int depth = 0, top = 0;
+    work[top++] = root * 2;
+    while (top > 0) {
+        int item = work[--top];
+        const ExprNode *node = &nodes[item >> 1];
+        if (item & 1) {
+            if (node->op == OP_POWI) {
+                prog->code[prog->length++] = OP_POWI;
+                prog->constants[prog->constantCount] = node->value;
+                prog->constantText[prog->constantCount] = NULL;
+                prog->constantLength[prog->constantCount] = 0;
+                prog->constantCount++;
+            } else {
+                emitOperator(prog, node->op, &depth);
+            }
+            continue;
+        }
+
+        switch (node->op) {
+        case OP_PUSH:
+            emitConstant(prog, node->value, node->text, node->len, &depth);
+            break;
+        case OP_VAR:
+            prog->code[prog->length++] = OP_VAR;
+            prog->variables[prog->variableCount++] = (unsigned char)node->variable;
+            pushOperand(prog, &depth);
+            break;
+        default:
+            work[top++] = item + 1;
+            if (operatorTable[node->op].arity == 2) work[top++] = node->right * 2;
+            work[top++] = node->left * 2;
+            break;
+        }
+    }
+}
+
+// 명령열을 최적화 (피연산자가 모자라는 등 실행할 수 없는 명령열은 그대로 둠)
+void optimizeProgram(Program *prog, Optimizer *opt) {
+    opt->before += prog->length;
+    if (!prog->stackValid) {
+        opt->after += prog->length;
+        return;
+    }
+
+    if (prog->length > opt->capacity) {
+        opt->capacity = prog->length > 2 * opt->capacity ? prog->length : 2 * opt->capacity;
+        opt->nodes = realloc(opt->nodes, opt->capacity * sizeof(ExprNode));
+        opt->work = realloc(opt->work, 2 * opt->capacity * sizeof(int));
+    }
+    ExprNode *nodes = opt->nodes;
+    int *stack = opt->work;
+    int top = 0, count = 0;
+    int constantIndex = 0, variableIndex = 0;
+    for (int i = 0; i < prog->length; i++) {
+        unsigned char op = prog->code[i];
+        if (op == OP_PUSH) {
+            nodes[count].op = OP_PUSH;
+            nodes[count].value = prog->constants[constantIndex];
+            nodes[count].text = prog->constantText[constantIndex];
+            nodes[count].len = prog->constantLength[constantIndex];
+            constantIndex++;
+            stack[top++] = count++;
+        } else if (op == OP_VAR) {
+            nodes[count].op = OP_VAR;
+            nodes[count].variable = prog->variables[variableIndex++];
+            stack[top++] = count++;
+        } else if (operatorTable[op].arity == 1) {
+            int left = stack[--top];
+            stack[top++] = optimizeNode(opt, count++, op, left, -1);
+        } else {
+            int right = stack[--top];
+            int left = stack[--top];
+            stack[top++] = optimizeNode(opt, count++, op, left, right);
+        }
+    }
+
+    int root = stack[0];
+    prog->length = 0;
+    prog->constantCount = 0;
+    prog->variableCount = 0;
+    prog->maxDepth = 0;
+    emitNodes(prog, nodes, root, opt->work);
+    opt->after += prog->length;
+}
+
+// 출력 버퍼 (줄마다 printf하지 않고 모아서 한 번에 씀)
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} OutputBuffer;
+
+void initOutputBuffer(OutputBuffer *out) {
+    out->data = NULL;
+    out->length = 0;
+    out->capacity = 0;
+}
+
+void freeOutputBuffer(OutputBuffer *out) {
+    free(out->data);
+    initOutputBuffer(out);
+}
+
+// 뒤에 extra바이트를 쓸 자리를 확보
+static char *reserveOutput(OutputBuffer *out, size_t extra) {
+    if (out->length + extra > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity : 4096;
+        while (capacity < out->length + extra) capacity *= 2;
+        out->data = realloc(out->data, capacity);
+        out->capacity = capacity;
+    }
+    return out->data + out->length;
+}
+
+void appendText(OutputBuffer *out, const char *text, size_t len) {
+    memcpy(reserveOutput(out, len), text, len);
+    out->length += len;
+}
+
+void appendString(OutputBuffer *out, const char *text) {
+    appendText(out, text, strlen(text));
+}
+
+void appendChar(OutputBuffer *out, char c) {
+    *reserveOutput(out, 1) = c;
+    out->length++;
+}
+
+// "Result: %.2f" 줄 추가 (%.2f는 DBL_MAX도 320자 안에 들어감)
+void appendResult(OutputBuffer *out, double result) {
+    char *dest = reserveOutput(out, 340);
+    out->length += snprintf(dest, 340, "Result: %.2f\n", result);
+}
+
+// 버퍼 내용을 파일에 쓰고 비움
+void flushOutput(OutputBuffer *out, FILE *fp) {
+    fwrite(out->data, 1, out->length, fp);
+    out->length = 0;
+}
+
+// 정확 계산 모드 (-e): + - * /와 정수 지수 ^를 기약분수로 계산
+// 분자와 분모가 64비트에 들어가는 동안은 128비트 중간값과 넘침 검사로 계산하고,
+// 넘치면 그 값부터 큰 정수(32비트 자리 배열)로 옮겨 계산함
+// 정수가 아닌 지수, 0의 음수 거듭제곱, 너무 큰 값처럼 분수로 나타낼 수 없으면 double로 대신 계산함
+// 곱셈은 O(n^2), 기약분수로 줄이는 유클리드 호제법은 O(n^2) 번의 자리 연산이므로 크기를 제한함
+#define EXACT_MAX_LIMBS 1024 // 큰 정수 하나의 최대 자리 수 (32768비트, 10진수 약 9800자리)
+#define EXACT_MAX_DECIMAL_EXPONENT 10000
+
+enum { EXACT_OK, EXACT_INVALID, EXACT_INEXACT };
+
+typedef struct {
+    uint32_t *limbs; // 절댓값 (아래 자리부터)
+    int length;      // 0이면 값이 0
+    int capacity;
+    int negative;
+} BigInt;
+
+typedef struct {
+    long long num, den; // big이 0일 때의 값 (den > 0, 기약분수)
+    int big;
+    BigInt bigNum, bigDen;
+} Rational;
+
+typedef struct {
+    Rational *stack;
+    int capacity;
+    BigInt temp[4];
+    int usedBig;        // 지금 줄에서 큰 정수를 썼는지
+    long long small;    // 64비트 안에서 끝난 줄 수
+    long long bigLines; // 큰 정수를 쓴 줄 수
+    long long fallback; // double로 대신 계산한 줄 수
+} ExactEvaluator;
+
+static void bigReserve(BigInt *a, int n) {
+    if (n > a->capacity) {
+        a->capacity = n > 2 * a->capacity ? n : 2 * a->capacity;
+        a->limbs = realloc(a->limbs, a->capacity * sizeof(uint32_t));
+    }
+}
+
+static void bigTrim(BigInt *a) {
+    while (a->length > 0 && a->limbs[a->length - 1] == 0) a->length--;
+    if (a->length == 0) a->negative = 0;
+}
+
+static void bigFree(BigInt *a) {
+    free(a->limbs);
+    memset(a, 0, sizeof(*a));
+}
+
+static void bigFromUint128(BigInt *a, unsigned __int128 magnitude) {
+    bigReserve(a, 4);
+    a->negative = 0;
+    a->length = 0;
+    while (magnitude) {
+        a->limbs[a->length++] = (uint32_t)magnitude;
+        magnitude >>= 32;
+    }
+}
+
+static void bigFromInt128(BigInt *a, __int128 value) {
+    bigFromUint128(a, value < 0 ? -(unsigned __int128)value : (unsigned __int128)value);
+    a->negative = value < 0;
+    bigTrim(a);
+}
+
+static void bigCopy(BigInt *dest, const BigInt *src) {
+    bigReserve(dest, src->length);
+    memcpy(dest->limbs, src->limbs, src->length * sizeof(uint32_t));
+    dest->length = src->length;
+    dest->negative = src->negative;
+}
+
+static void bigSwap(BigInt *a, BigInt *b) {
+    BigInt t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// long long에 들어가면 1
+static int bigToInt64(const BigInt *a, long long *value) {
+    if (a->length > 2) return 0;
+    uint64_t magnitude = 0;
+    for (int i = a->length - 1; i >= 0; i--) magnitude = (magnitude << 32) | a->limbs[i];
+    if (magnitude > (uint64_t)LLONG_MAX) return 0;
+    *value = a->negative ? -(long long)magnitude : (long long)magnitude;
+    return 1;
+}
+
+static int bigBitLength(const BigInt *a) {
+    return a->length ? 32 * a->length - __builtin_clz(a->limbs[a->length - 1]) : 0;
+}
+
+static int bigCompareAbs(const BigInt *a, const BigInt *b) {
+    if (a->length != b->length) return a->length < b->length ? -1 : 1;
+    for (int i = a->length - 1; i >= 0; i--) {
+        if (a->limbs[i] != b->limbs[i]) return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// r = |a| + |b| (r가 a나 b여도 됨)
+static void bigAddAbs(BigInt *r, const BigInt *a, const BigInt *b) {
+    if (a->length < b->length) {
+        const BigInt *t = a;
+        a = b;
+        b = t;
+    }
+    int n = a->length, m = b->length;
+    bigReserve(r, n + 1);
+    uint64_t carry = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t sum = (uint64_t)a->limbs[i] + (i < m ? b->limbs[i] : 0) + carry;
+        r->limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    r->limbs[n] = (uint32_t)carry;
+    r->length = n + 1;
+    bigTrim(r);
+}
+
+// r = |a| - |b|, |a| >= |b| (r가 a나 b여도 됨)
+static void bigSubAbs(BigInt *r, const BigInt *a, const BigInt *b) {
+    int n = a->length, m = b->length;
+    bigReserve(r, n);
+    int64_t borrow = 0;
+    for (int i = 0; i < n; i++) {
+        int64_t diff = (int64_t)a->limbs[i] - (i < m ? b->limbs[i] : 0) - borrow;
+        borrow = diff < 0;
+        r->limbs[i] = (uint32_t)(diff + (borrow << 32));
+    }
+    r->length = n;
+    bigTrim(r);
+}
+
+// r = a + b (subtract이면 a - b, r가 a나 b여도 됨)
+static void bigAdd(BigInt *r, const BigInt *a, const BigInt *b, int subtract) {
+    int negativeA = a->negative;
+    int negativeB = b->negative ^ (subtract && b->length > 0);
+    if (negativeA == negativeB) {
+        bigAddAbs(r, a, b);
+        r->negative = negativeA && r->length > 0;
+    } else if (bigCompareAbs(a, b) >= 0) {
+        bigSubAbs(r, a, b);
+        r->negative = negativeA && r->length > 0;
+    } else {
+        bigSubAbs(r, b, a);
+        r->negative = negativeB && r->length > 0;
+    }
+}
+
+// r = a * b (r는 a, b와 달라야 함, 자리 수가 EXACT_MAX_LIMBS를 넘으면 0)
+static int bigMul(BigInt *r, const BigInt *a, const BigInt *b) {
+    int n = a->length, m = b->length;
+    if (n + m > EXACT_MAX_LIMBS) return 0;
+    bigReserve(r, n + m);
+    memset(r->limbs, 0, (n + m) * sizeof(uint32_t));
+    for (int i = 0; i < n; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < m; j++) {
+            uint64_t t = (uint64_t)a->limbs[i] * b->limbs[j] + r->limbs[i + j] + carry;
+            r->limbs[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        r->limbs[i + m] = (uint32_t)carry;
+    }
+    r->length = n + m;
+    r->negative = a->negative != b->negative;
+    bigTrim(r);
+    return 1;
+}
+
+// a = a * m + add (절댓값만)
+static void bigMulSmall(BigInt *a, uint32_t m, uint32_t add) {
+    bigReserve(a, a->length + 1);
+    uint64_t carry = add;
+    for (int i = 0; i < a->length; i++) {
+        uint64_t t = (uint64_t)a->limbs[i] * m + carry;
+        a->limbs[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    if (carry) a->limbs[a->length++] = (uint32_t)carry;
+}
+
+// a = |a| / d, 나머지 반환
+static uint32_t bigDivSmall(BigInt *a, uint32_t d) {
+    uint64_t rem = 0;
+    for (int i = a->length - 1; i >= 0; i--) {
+        uint64_t cur = (rem << 32) | a->limbs[i];
+        a->limbs[i] = (uint32_t)(cur / d);
+        rem = cur % d;
+    }
+    int negative = a->negative;
+    bigTrim(a);
+    a->negative = negative && a->length > 0;
+    return (uint32_t)rem;
+}
+
+// q = |u| / |v|, r = |u| % |v| (Knuth 알고리즘 D, q와 r은 u, v와 달라야 하고 v는 0이 아님)
+static void bigDivMod(BigInt *q, BigInt *r, const BigInt *u, const BigInt *v) {
+    int m = u->length, n = v->length;
+    if (bigCompareAbs(u, v) < 0) {
+        q->length = 0;
+        q->negative = 0;
+        bigCopy(r, u);
+        r->negative = 0;
+        return;
+    }
+    bigReserve(q, m - n + 1);
+    if (n == 1) {
+        bigCopy(q, u);
+        q->negative = 0;
+        uint32_t rem = bigDivSmall(q, v->limbs[0]);
+        bigFromInt128(r, rem);
+        return;
+    }
+
+    int s = __builtin_clz(v->limbs[n - 1]);
+    uint32_t *vn = malloc(n * sizeof(uint32_t));
+    uint32_t *un = malloc((m + 1) * sizeof(uint32_t));
+    for (int i = n - 1; i > 0; i--) {
+        vn[i] = (v->limbs[i] << s) | (s ? v->limbs[i - 1] >> (32 - s) : 0);
+    }
+    vn[0] = v->limbs[0] << s;
+    un[m] = s ? u->limbs[m - 1] >> (32 - s) : 0;
+    for (int i = m - 1; i > 0; i--) {
+        un[i] = (u->limbs[i] << s) | (s ? u->limbs[i - 1] >> (32 - s) : 0);
+    }
+    un[0] = u->limbs[0] << s;
+
+    for (int j = m - n; j >= 0; j--) {
+        uint64_t num = ((uint64_t)un[j + n] << 32) | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1];
+        uint64_t rhat = num % vn[n - 1];
+        while ((qhat >> 32) || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >> 32) break;
+        }
+        int64_t borrow = 0, t;
+        for (int i = 0; i < n; i++) {
+            uint64_t p = qhat * vn[i];
+            t = (int64_t)un[i + j] - borrow - (int64_t)(p & 0xFFFFFFFFu);
+            un[i + j] = (uint32_t)t;
+            borrow = (int64_t)(p >> 32) - (t >> 32);
+        }
+        t = (int64_t)un[j + n] - borrow;
+        un[j + n] = (uint32_t)t;
+        q->limbs[j] = (uint32_t)qhat;
+        if (t < 0) {
+            q->limbs[j]--;
+            uint64_t carry = 0;
+            for (int i = 0; i < n; i++) {
+                uint64_t sum = (uint64_t)un[i + j] + vn[i] + carry;
+                un[i + j] = (uint32_t)sum;
+                carry = sum >> 32;
+            }
+            un[j + n] += (uint32_t)carry;
+        }
+    }
+    q->length = m - n + 1;
+    q->negative = 0;
+    bigTrim(q);
+
+    bigReserve(r, n);
+    for (int i = 0; i < n; i++) {
+        r->limbs[i] = (un[i] >> s) | (s ? un[i + 1] << (32 - s) : 0);
+    }
+    r->length = n;
+    r->negative = 0;
+    bigTrim(r);
+    free(vn);
+    free(un);
+}
+
+static unsigned __int128 gcd128(unsigned __int128 a, unsigned __int128 b) {
+    while (b) {
+        if (!(a >> 64) && !(b >> 64)) {
+            uint64_t x = (uint64_t)a, y = (uint64_t)b;
+            while (y) {
+                uint64_t t = x % y;
+                x = y;
+                y = t;
+            }
+            return x;
+        }
+        unsigned __int128 t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// |a|의 shift번째 비트부터 62비트
+static long long bigTopBits(const BigInt *a, int shift) {
+    unsigned __int128 bits = 0;
+    int first = shift / 32;
+    for (int i = first + 2; i >= first; i--) bits = (bits << 32) | (i < a->length ? a->limbs[i] : 0);
+    return (long long)((bits >> (shift % 32)) & ((1ULL << 62) - 1));
+}
+
+// r = x * |a| + y * |b| (결과는 0 이상이어야 하고 |a| >= |b|, r은 a, b와 달라야 함)
+static void bigLinear(BigInt *r, long long x, const BigInt *a, long long y, const BigInt *b) {
+    int n = a->length;
+    bigReserve(r, n + 2);
+    __int128 carry = 0;
+    for (int i = 0; i < n; i++) {
+        carry += (__int128)x * a->limbs[i] + (__int128)y * (i < b->length ? b->limbs[i] : 0);
+        r->limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    r->limbs[n] = (uint32_t)carry;
+    r->limbs[n + 1] = (uint32_t)(carry >> 32);
+    r->length = n + 2;
+    r->negative = 0;
+    bigTrim(r);
+}
+
+// a = gcd(|a|, |b|), |a| >= |b| (b와 temp[2], temp[3]은 덮어씀)
+// Lehmer 방식: 앞쪽 62비트만으로 유클리드 몫을 여러 번 미리 구해 한 번의 일차결합으로 적용하고,
+// 몫이 하나도 확실하지 않을 때만 나눗셈 한 번을 함 (128비트에 들어가면 gcd128로 끝냄)
+static void bigGcd(ExactEvaluator *ev, BigInt *a, BigInt *b) {
+    BigInt *q = &ev->temp[2], *rem = &ev->temp[3];
+    while (b->length > 0) {
+        if (a->length <= 4) {
+            unsigned __int128 x = 0, y = 0;
+            for (int i = a->length - 1; i >= 0; i--) x = (x << 32) | a->limbs[i];
+            for (int i = b->length - 1; i >= 0; i--) y = (y << 32) | b->limbs[i];
+            bigFromUint128(a, gcd128(x, y)); // 2^127 이상일 수 있으므로 부호 없이
+            return;
+        }
+        int shift = bigBitLength(a) - 62;
+        long long x = bigTopBits(a, shift), y = bigTopBits(b, shift);
+        long long A = 1, B = 0, C = 0, D = 1;
+        for (;;) {
+            long long xa, xb, yc, yd, t;
+            if (__builtin_add_overflow(x, A, &xa) || __builtin_add_overflow(x, B, &xb) ||
+                __builtin_add_overflow(y, C, &yc) || __builtin_add_overflow(y, D, &yd) || yc == 0 || yd == 0) {
+                break;
+            }
+            long long quotient = xa / yc;
+            if (quotient != xb / yd) break;
+            long long nextC, nextD, nextY;
+            if (__builtin_mul_overflow(quotient, C, &t) || __builtin_sub_overflow(A, t, &nextC) ||
+                __builtin_mul_overflow(quotient, D, &t) || __builtin_sub_overflow(B, t, &nextD) ||
+                __builtin_mul_overflow(quotient, y, &t) || __builtin_sub_overflow(x, t, &nextY)) {
+                break;
+            }
+            A = C;
+            C = nextC;
+            B = D;
+            D = nextD;
+            x = y;
+            y = nextY;
+        }
+        if (B == 0) {
+            bigDivMod(q, rem, a, b);
+            bigSwap(a, b);
+            bigSwap(b, rem);
+        } else {
+            bigLinear(q, A, a, B, b);
+            bigLinear(rem, C, a, D, b);
+            bigSwap(a, q);
+            bigSwap(b, rem);
+        }
+    }
+}
+
+// 큰 정수 분수를 기약분수로 줄이고 64비트에 들어가면 작은 형태로 되돌림
+static void normalizeBig(ExactEvaluator *ev, Rational *r) {
+    BigInt *a = &ev->temp[0], *b = &ev->temp[1], *q = &ev->temp[2], *rem = &ev->temp[3];
+    bigCopy(a, &r->bigNum);
+    a->negative = 0;
+    bigCopy(b, &r->bigDen);
+    if (bigCompareAbs(a, b) < 0) bigSwap(a, b);
+    bigGcd(ev, a, b);
+    if (!(a->length == 1 && a->limbs[0] == 1)) {
+        int negative = r->bigNum.negative;
+        bigDivMod(q, rem, &r->bigNum, a);
+        bigSwap(&r->bigNum, q);
+        r->bigNum.negative = negative && r->bigNum.length > 0;
+        bigDivMod(q, rem, &r->bigDen, a);
+        bigSwap(&r->bigDen, q);
+    }
+    if (bigToInt64(&r->bigNum, &r->num) && bigToInt64(&r->bigDen, &r->den)) r->big = 0;
+}
+
+static void toBig(Rational *r) {
+    if (r->big) return;
+    bigFromInt128(&r->bigNum, r->num);
+    bigFromInt128(&r->bigDen, r->den);
+    r->big = 1;
+}
+
+// 128비트 분수 num/den (den > 0)을 줄여 r에 넣음 (64비트에 안 들어가면 큰 정수로)
+static void setRational128(ExactEvaluator *ev, Rational *r, __int128 num, __int128 den) {
+    unsigned __int128 magnitude = num < 0 ? -(unsigned __int128)num : (unsigned __int128)num;
+    unsigned __int128 g = gcd128(magnitude, (unsigned __int128)den);
+    if (g > 1) {
+        num /= (__int128)g;
+        den /= (__int128)g;
+    }
+    if (num >= LLONG_MIN && num <= LLONG_MAX && den <= LLONG_MAX) {
+        r->big = 0;
+        r->num = (long long)num;
+        r->den = (long long)den;
+    } else {
+        r->big = 1;
+        bigFromInt128(&r->bigNum, num);
+        bigFromInt128(&r->bigDen, den);
+        ev->usedBig = 1;
+    }
+}
+
+// a = a ± b
+static int exactAdd(ExactEvaluator *ev, Rational *a, Rational *b, int subtract) {
+    if (!a->big && !b->big) {
+        __int128 left = (__int128)a->num * b->den;
+        __int128 right = (__int128)b->num * a->den;
+        __int128 num;
+        if (!(subtract ? __builtin_sub_overflow(left, right, &num) : __builtin_add_overflow(left, right, &num))) {
+            setRational128(ev, a, num, (__int128)a->den * b->den);
+            return EXACT_OK;
+        }
+    }
+    toBig(a);
+    toBig(b);
+    BigInt *left = &ev->temp[0], *right = &ev->temp[1], *den = &ev->temp[2];
+    if (!bigMul(left, &a->bigNum, &b->bigDen) || !bigMul(right, &b->bigNum, &a->bigDen) ||
+        !bigMul(den, &a->bigDen, &b->bigDen)) {
+        return EXACT_INEXACT;
+    }
+    bigAdd(&a->bigNum, left, right, subtract);
+    bigSwap(&a->bigDen, den);
+    ev->usedBig = 1;
+    normalizeBig(ev, a);
+    return EXACT_OK;
+}
+
+// a = a * b (divide이면 a / b)
+static int exactMul(ExactEvaluator *ev, Rational *a, Rational *b, int divide) {
+    if (divide) {
+        if (b->big ? b->bigNum.length == 0 : b->num == 0) return EXACT_INVALID;
+        // 역수로 바꿔 곱함 (분모는 항상 양수로)
+        if (b->big) {
+            bigSwap(&b->bigNum, &b->bigDen);
+            b->bigNum.negative = b->bigDen.negative;
+            b->bigDen.negative = 0;
+        } else if (b->num == LLONG_MIN) {
+            toBig(b);
+            bigSwap(&b->bigNum, &b->bigDen);
+            b->bigNum.negative = 1;
+            b->bigDen.negative = 0;
+        } else {
+            long long num = b->den, den = b->num;
+            b->num = den < 0 ? -num : num;
+            b->den = den < 0 ? -den : den;
+        }
+    }
+    if (!a->big && !b->big) {
+        setRational128(ev, a, (__int128)a->num * b->num, (__int128)a->den * b->den);
+        return EXACT_OK;
+    }
+    toBig(a);
+    toBig(b);
+    BigInt *num = &ev->temp[0], *den = &ev->temp[1];
+    if (!bigMul(num, &a->bigNum, &b->bigNum) || !bigMul(den, &a->bigDen, &b->bigDen)) return EXACT_INEXACT;
+    bigSwap(&a->bigNum, num);
+    bigSwap(&a->bigDen, den);
+    ev->usedBig = 1;
+    normalizeBig(ev, a);
+    return EXACT_OK;
+}
+
+// base = base^n (n >= 0, 제곱-곱셈)
+static int bigPower(ExactEvaluator *ev, BigInt *base, long long n) {
+    BigInt *result = &ev->temp[2], *square = &ev->temp[3], *t = &ev->temp[1];
+    bigFromInt128(result, 1);
+    while (n > 0) {
+        if (n & 1) {
+            if (!bigMul(t, result, base)) return 0;
+            bigSwap(result, t);
+        }
+        n >>= 1;
+        if (n > 0) {
+            if (!bigMul(square, base, base)) return 0;
+            bigSwap(base, square);
+        }
+    }
+    bigSwap(base, result);
+    return 1;
+}
+
+// a = -a (absolute이면 |a|)
+static int exactNegate(Rational *a, int absolute) {
+    if (!a->big && a->num == LLONG_MIN) toBig(a);
+    if (a->big) a->bigNum.negative = absolute ? 0 : !a->bigNum.negative && a->bigNum.length > 0;
+    else a->num = absolute && a->num >= 0 ? a->num : -a->num;
+    return EXACT_OK;
+}
+
+// a = a ^ b (b는 정수여야 함, 분자와 분모가 서로소이므로 각각 거듭제곱하면 기약분수)
+static int exactPow(ExactEvaluator *ev, Rational *a, Rational *b) {
+    long long n;
+    if (b->big || b->den != 1) return EXACT_INEXACT;
+    n = b->num;
+    unsigned long long count = n < 0 ? -(unsigned long long)n : (unsigned long long)n;
+    if (!a->big && (a->num == 0 || ((a->num == 1 || a->num == -1) && a->den == 1))) {
+        // 0, 1, -1은 지수가 아무리 커도 바로 구함
+        if (a->num == 0) {
+            if (n < 0) return EXACT_INEXACT; // pow(0, 음수)는 무한대
+            if (n == 0) a->num = 1;
+        } else if (!(count & 1)) {
+            a->num = 1;
+        }
+        return EXACT_OK;
+    }
+    if (count > EXACT_MAX_LIMBS * 32ULL) return EXACT_INEXACT;
+
+    if (!a->big) {
+        long long num = 1, den = 1, baseNum = a->num, baseDen = a->den;
+        int overflow = 0;
+        for (unsigned long long e = count; e && !overflow; e >>= 1) {
+            if (e & 1) {
+                overflow |= __builtin_mul_overflow(num, baseNum, &num);
+                overflow |= __builtin_mul_overflow(den, baseDen, &den);
+            }
+            if (e > 1) {
+                overflow |= __builtin_mul_overflow(baseNum, baseNum, &baseNum);
+                overflow |= __builtin_mul_overflow(baseDen, baseDen, &baseDen);
+            }
+        }
+        if (!overflow) {
+            if (n < 0) {
+                long long t = num;
+                num = den;
+                den = t;
+                if (den < 0) {
+                    if (num == LLONG_MIN || den == LLONG_MIN) overflow = 1;
+                    num = -num;
+                    den = -den;
+                }
+            }
+            if (!overflow) {
+                a->num = num;
+                a->den = den;
+                return EXACT_OK;
+            }
+        }
+    }
+
+    toBig(a);
+    // 결과 비트 수를 미리 어림해 너무 크면 계산하지 않음
+    int bits = bigBitLength(&a->bigNum) > bigBitLength(&a->bigDen) ? bigBitLength(&a->bigNum) : bigBitLength(&a->bigDen);
+    if ((unsigned long long)(bits - 1) * count > EXACT_MAX_LIMBS * 32ULL) return EXACT_INEXACT;
+    int negative = a->bigNum.negative && (count & 1);
+    a->bigNum.negative = 0;
+    if (!bigPower(ev, &a->bigNum, (long long)count) || !bigPower(ev, &a->bigDen, (long long)count)) {
+        return EXACT_INEXACT;
+    }
+    if (n < 0) bigSwap(&a->bigNum, &a->bigDen);
+    a->bigNum.negative = negative && a->bigNum.length > 0;
+    ev->usedBig = 1;
+    if (bigToInt64(&a->bigNum, &a->num) && bigToInt64(&a->bigDen, &a->den)) a->big = 0;
+    return EXACT_OK;
+}
+
+// 숫자 토큰 원문을 분수로 (strtod가 받아들인 [+-]숫자[.숫자][e[+-]숫자] 형태)
+static int parseExact(ExactEvaluator *ev, Rational *r, const char *text, int len) {
+    int i = 0, negative = 0;
+    if (i < len && (text[i] == '+' || text[i] == '-')) negative = text[i++] == '-';
+
+    // 가수는 18자리까지 long long으로, 넘으면 큰 정수로 모음
+    long long mantissa = 0;
+    int digits = 0, fraction = 0, seenPoint = 0;
+    BigInt *big = &ev->temp[0];
+    int isBig = 0;
+    for (; i < len && (isdigit((unsigned char)text[i]) || text[i] == '.'); i++) {
+        if (text[i] == '.') {
+            seenPoint = 1;
+            continue;
+        }
+        int d = text[i] - '0';
+        if (seenPoint) fraction++;
+        if (!isBig && digits < 18) {
+            mantissa = mantissa * 10 + d;
+        } else {
+            if (!isBig) {
+                bigFromInt128(big, mantissa);
+                isBig = 1;
+            }
+            if (big->length >= EXACT_MAX_LIMBS) return EXACT_INEXACT;
+            bigMulSmall(big, 10, (uint32_t)d);
+        }
+        digits++;
+    }
+    long long exponent = 0;
+    if (i < len && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        int negativeExponent = 0;
+        if (i < len && (text[i] == '+' || text[i] == '-')) negativeExponent = text[i++] == '-';
+        for (; i < len; i++) {
+            exponent = exponent * 10 + (text[i] - '0');
+            if (exponent > EXACT_MAX_DECIMAL_EXPONENT) return EXACT_INEXACT;
+        }
+        if (negativeExponent) exponent = -exponent;
+    }
+    long long scale = exponent - fraction; // 값 = 가수 * 10^scale
+    if (scale > EXACT_MAX_DECIMAL_EXPONENT || scale < -EXACT_MAX_DECIMAL_EXPONENT) return EXACT_INEXACT;
+
+    if (!isBig && scale > -19 && scale < 19) {
+        long long power = 1;
+        for (long long k = scale < 0 ? -scale : scale; k > 0; k--) power *= 10;
+        long long value = negative ? -mantissa : mantissa;
+        if (scale >= 0) {
+            long long num;
+            if (!__builtin_mul_overflow(value, power, &num)) {
+                r->big = 0;
+                r->num = num;
+                r->den = 1;
+                return EXACT_OK;
+            }
+        } else {
+            setRational128(ev, r, value, power);
+            return EXACT_OK;
+        }
+    }
+
+    // 큰 정수 경로: 가수 * 10^scale
+    if (!isBig) bigFromInt128(big, mantissa);
+    bigSwap(&r->bigNum, big);
+    r->bigNum.negative = negative && r->bigNum.length > 0;
+    bigFromInt128(&r->bigDen, 10);
+    if (!bigPower(ev, &r->bigDen, scale < 0 ? -scale : scale)) return EXACT_INEXACT;
+    r->big = 1;
+    ev->usedBig = 1;
+    if (scale >= 0) {
+        BigInt *num = &ev->temp[0];
+        if (!bigMul(num, &r->bigNum, &r->bigDen)) return EXACT_INEXACT;
+        bigSwap(&r->bigNum, num);
+        bigFromInt128(&r->bigDen, 1);
+    }
+    normalizeBig(ev, r);
+    return EXACT_OK;
+}
+
+void initExactEvaluator(ExactEvaluator *ev) {
+    memset(ev, 0, sizeof(*ev));
+}
+
+void freeExactEvaluator(ExactEvaluator *ev) {
+    for (int i = 0; i < ev->capacity; i++) {
+        bigFree(&ev->stack[i].bigNum);
+        bigFree(&ev->stack[i].bigDen);
+    }
+    free(ev->stack);
+    for (int i = 0; i < 4; i++) bigFree(&ev->temp[i]);
+    ev->stack = NULL;
+    ev->capacity = 0;
+}
+
+// runExact의 본체 (변수나 최적화기가 만든 명령처럼 원문 상수가 없는 명령열은 EXACT_INEXACT)
+static int executeExact(ExactEvaluator *ev, const Program *prog, const Rational **result) {
+    if (!prog->stackValid) return EXACT_INVALID;
+    if (prog->maxDepth > ev->capacity) {
+        int capacity = prog->maxDepth > 2 * ev->capacity ? prog->maxDepth : 2 * ev->capacity;
+        ev->stack = realloc(ev->stack, capacity * sizeof(Rational));
+        memset(ev->stack + ev->capacity, 0, (capacity - ev->capacity) * sizeof(Rational));
+        ev->capacity = capacity;
+    }
+
+    Rational *stack = ev->stack;
+    int sp = 0, constant = 0;
+    ev->usedBig = 0;
+    for (int i = 0; i < prog->length; i++) {
+        int status = EXACT_INEXACT;
+        unsigned char op = prog->code[i];
+        if (op == OP_PUSH) {
+            const char *text = prog->constantText[constant];
+            if (!text) return EXACT_INEXACT;
+            status = parseExact(ev, &stack[sp++], text, prog->constantLength[constant++]);
+        } else if (op >= OP_ADD && op <= OP_POW) {
+            Rational *b = &stack[--sp];
+            Rational *a = &stack[sp - 1];
+            if (op == OP_ADD || op == OP_SUB) status = exactAdd(ev, a, b, op == OP_SUB);
+            else if (op == OP_MUL || op == OP_DIV) status = exactMul(ev, a, b, op == OP_DIV);
+            else status = exactPow(ev, a, b);
+        } else if (op == OP_NEG || op == OP_ABS) {
+            status = exactNegate(&stack[sp - 1], op == OP_ABS);
+        }
+        if (status != EXACT_OK) return status;
+    }
+    *result = &stack[0];
+    return EXACT_OK;
+}
+
+// 명령열을 분수로 실행 (EXACT_OK이면 *result에 결과, 통계도 셈)
+int runExact(ExactEvaluator *ev, const Program *prog, const Rational **result) {
+    int status = executeExact(ev, prog, result);
+    if (status == EXACT_INEXACT) ev->fallback++;
+    else if (ev->usedBig) ev->bigLines++;
+    else ev->small++;
+    return status;
+}
+
+// 큰 정수를 10진수로 (10^9씩 나눠 아래 자리부터 구함)
+static void appendBigInt(OutputBuffer *out, const BigInt *a, BigInt *scratch) {
+    if (a->length == 0) {
+        appendChar(out, '0');
+        return;
+    }
+    bigCopy(scratch, a);
+    int chunkCount = 0;
+    uint32_t *chunks = malloc((a->length * 10 / 9 + 2) * sizeof(uint32_t));
+    do {
+        chunks[chunkCount++] = bigDivSmall(scratch, 1000000000u);
+    } while (scratch->length > 0);
+    char text[16];
+    if (a->negative) appendChar(out, '-');
+    appendText(out, text, snprintf(text, sizeof(text), "%u", chunks[chunkCount - 1]));
+    for (int i = chunkCount - 2; i >= 0; i--) {
+        appendText(out, text, snprintf(text, sizeof(text), "%09u", chunks[i]));
+    }
+    free(chunks);
+}
+
+// "Result: 분자/분모" 줄 추가 (정수이면 분모 생략)
+void appendExactResult(OutputBuffer *out, const Rational *r, ExactEvaluator *ev) {
+    appendString(out, "Result: ");
+    if (!r->big) {
+        char text[48];
+        appendText(out, text, snprintf(text, sizeof(text), "%lld", r->num));
+        if (r->den != 1) appendText(out, text, snprintf(text, sizeof(text), "/%lld", r->den));
+    } else {
+        appendBigInt(out, &r->bigNum, &ev->temp[0]);
+        if (!(r->bigDen.length == 1 && r->bigDen.limbs[0] == 1)) {
+            appendChar(out, '/');
+            appendBigInt(out, &r->bigDen, &ev->temp[0]);
+        }
+    }
+    appendChar(out, '\n');
+}
+
+// 결과 캐시: 토큰열 → 그 줄이 만든 출력 (같은 수식이 다시 오면 컴파일과 계산을 건너뜀)
+// 항목 수가 용량을 넘으면 가장 오래 쓰지 않은 항목을 버림
+typedef struct {
+    unsigned long long hash;
+    char *text;       // 키 바로 뒤에 출력이 이어 붙은 블록
+    int keyLength;
+    int outputLength;
+    int next;         // 같은 버킷의 다음 항목 (-1이면 끝)
+    int newer, older; // 최근 사용 순서 목록
+} CacheEntry;
+
+typedef struct {
+    int capacity;
+    int count;
+    int bucketMask;
+    int *buckets;
+    CacheEntry *entries;
+    int newest, oldest;
+    OutputBuffer key; // 지금 찾는 줄의 키
+    long long hits, misses, evictions;
+} ResultCache;
+
+void initResultCache(ResultCache *cache, int capacity) {
+    int buckets = 16;
+    while (buckets < capacity * 2) buckets *= 2;
+    cache->capacity = capacity;
+    cache->count = 0;
+    cache->bucketMask = buckets - 1;
+    cache->buckets = malloc(buckets * sizeof(int));
+    memset(cache->buckets, -1, buckets * sizeof(int));
+    cache->entries = malloc(capacity * sizeof(CacheEntry));
+    cache->newest = cache->oldest = -1;
+    initOutputBuffer(&cache->key);
+    cache->hits = cache->misses = cache->evictions = 0;
+}
+
+void freeResultCache(ResultCache *cache) {
+    for (int i = 0; i < cache->count; i++) free(cache->entries[i].text);
+    free(cache->entries);
+    free(cache->buckets);
+    freeOutputBuffer(&cache->key);
+}
+
+// 토큰열을 키로 씀 (숫자는 '#' + 원문 + ' ', 나머지는 한 글자씩이므로 공백만 다른 줄은 같은 키)
+static void encodeTokens(const TokenArena *arena, OutputBuffer *key) {
+    key->length = 0;
+    for (int i = 0; i < arena->count; i++) {
+        const Token *tok = &arena->tokens[i];
+        switch (tok->kind) {
+        case TOKEN_NUMBER:
+            appendChar(key, '#');
+            appendText(key, tok->text, tok->length);
+            appendChar(key, ' ');
+            break;
+        case TOKEN_OPERATOR: appendChar(key, tok->op); break;
+        case TOKEN_OPEN: appendChar(key, '('); break;
+        case TOKEN_CLOSE: appendChar(key, ')'); break;
+        case TOKEN_NEGATE: appendChar(key, '~'); break;
+        case TOKEN_COMMA: appendChar(key, ','); break;
+        case TOKEN_FUNCTION:
+            appendChar(key, '@');
+            appendChar(key, tok->op);
+            break;
+        }
+    }
+}
+
+static unsigned long long hashLine(const char *line, int len) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (int i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)line[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void unlinkRecent(ResultCache *cache, int index) {
+    CacheEntry *entry = &cache->entries[index];
+    if (entry->newer >= 0) cache->entries[entry->newer].older = entry->older;
+    else cache->newest = entry->older;
+    if (entry->older >= 0) cache->entries[entry->older].newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+static void linkNewest(ResultCache *cache, int index) {
+    CacheEntry *entry = &cache->entries[index];
+    entry->newer = -1;
+    entry->older = cache->newest;
+    if (cache->newest >= 0) cache->entries[cache->newest].newer = index;
+    else cache->oldest = index;
+    cache->newest = index;
+}
+
+// 캐시에 있으면 출력을 out에 붙이고 1 반환
+int lookupCache(ResultCache *cache, const char *line, int len, unsigned long long hash, OutputBuffer *out) {
+    for (int i = cache->buckets[hash & cache->bucketMask]; i >= 0; i = cache->entries[i].next) {
+        CacheEntry *entry = &cache->entries[i];
+        if (entry->hash == hash && entry->keyLength == len && !memcmp(entry->text, line, len)) {
+            appendText(out, entry->text + len, entry->outputLength);
+            if (cache->newest != i) {
+                unlinkRecent(cache, i);
+                linkNewest(cache, i);
+            }
+            cache->hits++;
+            return 1;
+        }
+    }
+    cache->misses++;
+    return 0;
+}
+
+void storeCache(ResultCache *cache, const char *line, int len, unsigned long long hash, const char *output,
+                int outputLength) {
+    int index;
+    if (cache->count < cache->capacity) {
+        index = cache->count++;
+    } else {
+        // 가장 오래된 항목을 버킷에서 빼고 그 자리를 재사용
+        index = cache->oldest;
+        CacheEntry *victim = &cache->entries[index];
+        int *link = &cache->buckets[victim->hash & cache->bucketMask];
+        while (*link != index) link = &cache->entries[*link].next;
+        *link = victim->next;
+        unlinkRecent(cache, index);
+        free(victim->text);
+        cache->evictions++;
+    }
+
+    CacheEntry *entry = &cache->entries[index];
+    entry->hash = hash;
+    entry->text = malloc(len + outputLength);
+    memcpy(entry->text, line, len);
+    memcpy(entry->text + len, output, outputLength);
+    entry->keyLength = len;
+    entry->outputLength = outputLength;
+    int *bucket = &cache->buckets[hash & cache->bucketMask];
+    entry->next = *bucket;
+    *bucket = index;
+    linkNewest(cache, index);
+}
+
+// 명령열을 후위 표기식으로 출력 (상수는 원문 그대로, 변수는 이름으로)
+void printProgram(const Program *prog, const VariableTable *variableNames, OutputBuffer *out) {
+    int constantIndex = 0, variableIndex = 0;
+    appendString(out, "Postfix: ");
+    for (int i = 0; i < prog->length; i++) {
+        if (prog->code[i] == OP_PUSH) {
+            if (!prog->constantText[constantIndex]) {
+                char text[32];
+                appendText(out, text, snprintf(text, sizeof(text), "%.17g", prog->constants[constantIndex]));
+            } else {
+                appendText(out, prog->constantText[constantIndex], prog->constantLength[constantIndex]);
+            }
+            constantIndex++;
+        } else if (prog->code[i] == OP_VAR) {
+            appendString(out, variableNames->names[prog->variables[variableIndex++]]);
+        } else {
+            appendString(out, operatorTable[prog->code[i]].name);
+        }
+        appendChar(out, ' ');
+    }
+    appendChar(out, '\n');
+}
+
+// 한 줄 처리: 원문 [line, line + length)를 토큰으로 나눠 바이트코드로 컴파일해 실행
+// (opt가 NULL이 아니면 출력 후 최적화해서 실행, exact가 NULL이 아니면 분수로 정확히 계산,
+//  cache가 NULL이 아니면 같은 토큰열의 출력을 다시 씀)
+void processLine(const char *line, size_t length, Program *prog, Optimizer *opt, ExactEvaluator *exact,
+                 ResultCache *cache, OutputBuffer *out) {
+    if (isInvalidText(line, length) ||
+        !lexExpression(&prog->tokens, line, length, extendedLanguage ? LEX_EXTENDED : 0)) {
+        appendString(out, "Invalid Expression\n");
+        return;
+    }
+
+    // 출력은 토큰열에만 달려 있으므로 그대로 캐시 키로 씀
+    size_t start = out->length;
+    unsigned long long hash = 0;
+    if (cache && cache->capacity > 0) {
+        encodeTokens(&prog->tokens, &cache->key);
+        hash = hashLine(cache->key.data, (int)cache->key.length);
+        if (lookupCache(cache, cache->key.data, (int)cache->key.length, hash, out)) return;
+    }
+
+    if (!compileTokens(prog, NULL)) {
+        appendString(out, "Invalid Expression\n");
+    } else {
+        // 출력: 후위 표기식
+        printProgram(prog, NULL, out);
+
+        // 정확 계산은 상수 원문이 필요하므로 최적화 전에 실행 (분수로 못 나타내면 아래 double 계산)
+        const Rational *exactResult;
+        int exactStatus = exact ? runExact(exact, prog, &exactResult) : EXACT_INEXACT;
+        if (exactStatus == EXACT_OK) {
+            appendExactResult(out, exactResult, exact);
+        } else if (exactStatus == EXACT_INVALID) {
+            appendString(out, "Result: Invalid Expression\n");
+        } else {
+            if (opt) optimizeProgram(prog, opt);
+
+            // 출력: 결과
+            double result;
+            if (!runProgram(prog, NULL, &result)) {
+                appendString(out, "Result: Invalid Expression\n");
+            } else {
+                appendResult(out, result);
+            }
+        }
+    }
+
+    if (cache && cache->capacity > 0) {
+        storeCache(cache, cache->key.data, (int)cache->key.length, hash, out->data + start,
+                   (int)(out->length - start));
+    }
+}
+
+void processLineReference(char *line, OutputBuffer *out) {
+    if (isInvalidLine(line)) {
+        appendString(out, "Invalid Expression\n");
+        return;
+    }
+
+    preprocess_line(line);
+
+    char tokens[MAX_TOKENS][MAX_TOKEN_LEN];
+    int tokenCount = tokenize(line, tokens);
+    if (tokenCount < 1) {
+        appendString(out, "Invalid Expression\n");
+        return;
+    }
+
+    char postfix[MAX_TOKENS][MAX_TOKEN_LEN];
+    int postfixCount = toPostfix(tokens, tokenCount, postfix);
+    if (postfixCount < 1) {
+        appendString(out, "Invalid Expression\n");
+        return;
+    }
+
+    // 출력: 후위 표기식
+    appendString(out, "Postfix: ");
+    for (int i = 0; i < postfixCount; i++) {
+        appendString(out, postfix[i]);
+        appendChar(out, ' ');
+    }
+    appendChar(out, '\n');
+
+    // 출력: 결과
+    double result;
+    if (!evaluatePostfix(postfix, postfixCount, &result)) {
+        appendString(out, "Result: Invalid Expression\n");
+    } else {
+        appendResult(out, result);
+    }
+}
+
+// 일괄 처리 모드: 입력 파일을 매핑해 줄 경계에서 구간으로 나누고 여러 스레드가 구간별 버퍼에
+// 결과를 쓰면 메인 스레드가 원래 순서대로 내보냄
+#define RANGE_BYTES (256 * 1024)
+#define RANGE_WINDOW 64 // 아직 내보내지 않은 구간이 이만큼 쌓이면 작업 스레드가 기다림
+
+typedef struct {
+    const char *begin;
+    const char *end;
+    int done;
+    OutputBuffer out;
+} LineRange;
+
+typedef struct {
+    LineRange *ranges;
+    int rangeCount;
+    int nextRange;    // 다음에 가져갈 구간
+    int writtenRange; // 이 번호 앞의 구간은 모두 출력됨
+    int reference;
+    Optimizer *optimizer; // NULL이 아니면 각 스레드가 최적화한 통계를 여기에 합침
+    ExactEvaluator *exact; // NULL이 아니면 각 스레드가 정확 계산한 통계를 여기에 합침
+    ResultCache *cache;   // NULL이 아니면 각 스레드가 같은 용량의 캐시를 따로 두고 통계를 여기에 합침
+    pthread_mutex_t lock;
+    pthread_cond_t rangeDone;
+    pthread_cond_t rangeWritten;
+} BatchJob;
+
+// 구간 안의 줄을 하나씩 처리 (줄 끝의 \r\n은 떼고, 줄 안에 \r이 있으면 거기까지만 씀)
+// 컴파일 경로는 구간을 복사하지 않고 줄 길이에 한계가 없음
+// 기준 구현은 fgets(line, MAX_LINE)과 같은 단위로 잘라 처리 (MAX_LINE - 1바이트보다 긴 줄은 여러 조각)
+static void processRange(const char *p, const char *end, Program *prog, Optimizer *opt, ExactEvaluator *exact,
+                         ResultCache *cache, int reference, OutputBuffer *out) {
+    char line[MAX_LINE];
+    while (p < end) {
+        const char *lineEnd = memchr(p, '\n', end - p);
+        lineEnd = lineEnd ? lineEnd + 1 : end;
+        if (!reference) {
+            const char *textEnd = memchr(p, '\r', lineEnd - p);
+            if (!textEnd) textEnd = lineEnd > p && lineEnd[-1] == '\n' ? lineEnd - 1 : lineEnd;
+            processLine(p, textEnd - p, prog, opt, exact, cache, out);
+            p = lineEnd;
+            continue;
+        }
+
+        size_t len = lineEnd - p;
+        if (len > MAX_LINE - 1) len = MAX_LINE - 1;
+        memcpy(line, p, len);
+        line[len] = '\0';
+        p += len;
+
+        line[strcspn(line, "\r\n")] = 0;
+        processLineReference(line, out);
+    }
+}
+
+static void *batchWorker(void *arg) {
+    BatchJob *job = arg;
+    Program *prog = malloc(sizeof(Program));
+    initProgram(prog);
+    Optimizer *opt = NULL;
+    if (job->optimizer) {
+        opt = malloc(sizeof(Optimizer));
+        initOptimizer(opt);
+    }
+    ExactEvaluator *exact = NULL;
+    if (job->exact) {
+        exact = malloc(sizeof(ExactEvaluator));
+        initExactEvaluator(exact);
+    }
+    ResultCache *cache = NULL;
+    if (job->cache) {
+        cache = malloc(sizeof(ResultCache));
+        initResultCache(cache, job->cache->capacity);
+    }
+
+    pthread_mutex_lock(&job->lock);
+    while (job->nextRange < job->rangeCount) {
+        int index = job->nextRange;
+        if (index >= job->writtenRange + RANGE_WINDOW) {
+            pthread_cond_wait(&job->rangeWritten, &job->lock);
+            continue;
+        }
+        job->nextRange++;
+        pthread_mutex_unlock(&job->lock);
+
+        LineRange *range = &job->ranges[index];
+        processRange(range->begin, range->end, prog, opt, exact, cache, job->reference, &range->out);
+
+        pthread_mutex_lock(&job->lock);
+        range->done = 1;
+        pthread_cond_broadcast(&job->rangeDone);
+    }
+    if (opt) {
+        job->optimizer->before += opt->before;
+        job->optimizer->after += opt->after;
+        job->optimizer->folded += opt->folded;
+        job->optimizer->negated += opt->negated;
+        job->optimizer->powers += opt->powers;
+    }
+    if (exact) {
+        job->exact->small += exact->small;
+        job->exact->bigLines += exact->bigLines;
+        job->exact->fallback += exact->fallback;
+    }
+    if (cache) {
+        job->cache->hits += cache->hits;
+        job->cache->misses += cache->misses;
+        job->cache->evictions += cache->evictions;
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    if (cache) freeResultCache(cache);
+    free(cache);
+    if (exact) freeExactEvaluator(exact);
+    free(exact);
+    if (opt) freeOptimizer(opt);
+    free(opt);
+    freeProgram(prog);
+    free(prog);
+    return NULL;
+}
+
+// 입력 파일 전체를 numThreads개 스레드로 처리 (0 이하이면 CPU 코어 수)
+// optimizer가 NULL이 아니면 최적화해서 실행하고, exact가 NULL이 아니면 분수로 정확히 계산하고,
+// cache가 NULL이 아니면 스레드마다 그 용량의 캐시를 씀 (통계는 모두 여기에 합쳐 줌)
+int processFileParallel(const char *filename, int numThreads, int reference, Optimizer *optimizer,
+                        ExactEvaluator *exact, ResultCache *cache, FILE *output) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror(filename);
+        close(fd);
+        return 1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror(filename);
+        return 1;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+
+    if (numThreads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        numThreads = cores > 0 ? (int)cores : 1;
+    }
+
+    // 약 RANGE_BYTES 크기로 자르되 항상 줄 끝('\n' 다음)에서 자름
+    BatchJob job;
+    int capacity = (int)(size / RANGE_BYTES) + 2;
+    job.ranges = calloc(capacity, sizeof(LineRange));
+    job.rangeCount = 0;
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end) {
+        const char *cut = end - p > RANGE_BYTES ? p + RANGE_BYTES : end;
+        if (cut < end) {
+            const char *newline = memchr(cut, '\n', end - cut);
+            cut = newline ? newline + 1 : end;
+        }
+        LineRange *range = &job.ranges[job.rangeCount++];
+        range->begin = p;
+        range->end = cut;
+        initOutputBuffer(&range->out);
+        p = cut;
+    }
+
+    job.nextRange = 0;
+    job.writtenRange = 0;
+    job.reference = reference;
+    job.optimizer = optimizer;
+    job.exact = exact;
+    job.cache = cache;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.rangeDone, NULL);
+    pthread_cond_init(&job.rangeWritten, NULL);
+
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    int started = 0;
+    for (int t = 0; t < numThreads; t++) {
+        if (pthread_create(&threads[t], NULL, batchWorker, &job) != 0) break;
+        started++;
+    }
+    if (started == 0) batchWorker(&job);
+
+    // 끝난 구간을 순서대로 내보냄
+    pthread_mutex_lock(&job.lock);
+    while (job.writtenRange < job.rangeCount) {
+        LineRange *range = &job.ranges[job.writtenRange];
+        if (!range->done) {
+            pthread_cond_wait(&job.rangeDone, &job.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&job.lock);
+        flushOutput(&range->out, output);
+        freeOutputBuffer(&range->out);
+        pthread_mutex_lock(&job.lock);
+        job.writtenRange++;
+        pthread_cond_broadcast(&job.rangeWritten);
+    }
+    pthread_mutex_unlock(&job.lock);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.rangeDone);
+    pthread_cond_destroy(&job.rangeWritten);
+    free(job.ranges);
+    munmap((void *)data, size);
+    return 0;
+}
+
+// 표 모드: 수식을 한 번만 컴파일하고 표의 각 행을 변수 값으로 넣어 계산
+// 표의 첫 줄은 변수 이름, 이후 줄은 값 (쉼표, 세미콜론, 공백으로 구분)
+// 행은 TABLE_BLOCK개씩 열 배열로 모아 runProgramBlock으로 한꺼번에 계산
+#define TABLE_BLOCK 256
+
+static int isFieldSeparator(char c) {
+    return c == ',' || c == ';' || isspace((unsigned char)c);
+}
+
+// 한 줄의 필드를 차례로 돌며 fieldVariable[필드 번호]가 가리키는 변수 열의 row번 칸에 값을 채움
+// 필요한 변수를 모두 읽었으면 1
+static int parseTableRow(const char *p, const int *fieldVariable, int fieldCount, int variableCount,
+                         double **columns, int row) {
+    int found = 0;
+    for (int field = 0; *p; field++) {
+        while (*p && isFieldSeparator(*p)) p++;
+        if (!*p) break;
+        char *end;
+        double value = strtod(p, &end);
+        int ok = end != p && (!*end || isFieldSeparator(*end));
+        while (*end && !isFieldSeparator(*end)) end++;
+        p = end;
+        if (field >= fieldCount || fieldVariable[field] < 0) continue;
+        if (!ok) return 0;
+        columns[fieldVariable[field]][row] = value;
+        found++;
+    }
+    return found == variableCount;
+}
+
+int evaluateTable(const char *formula, const char *tableFile, Optimizer *opt, FILE *output) {
+    VariableTable vars;
+    initVariableTable(&vars);
+    Program *prog = malloc(sizeof(Program));
+    initProgram(prog);
+    if (isInvalidLine(formula) || !compileExpression(formula, strlen(formula), prog, &vars)) {
+        fprintf(stderr, "수식을 해석할 수 없습니다: %s\n", formula);
+        freeProgram(prog);
+        free(prog);
+        return 1;
+    }
+
+    FILE *fp = fopen(tableFile, "r");
+    if (!fp) {
+        perror(tableFile);
+        freeProgram(prog);
+        free(prog);
+        return 1;
+    }
+
+    // 첫 줄: 열 이름을 변수 번호에 연결 (수식에 없는 열은 무시)
+    char *row = NULL;
+    size_t rowCapacity = 0;
+    ssize_t rowLength = getline(&row, &rowCapacity, fp);
+    int fieldCount = 0;
+    int *fieldVariable = NULL;
+    int *hasColumn = calloc(vars.count + 1, sizeof(int));
+    for (char *p = rowLength > 0 ? row : ""; *p;) {
+        while (*p && isFieldSeparator(*p)) p++;
+        if (!*p) break;
+        char *name = p;
+        while (*p && !isFieldSeparator(*p)) p++;
+        int index = -1;
+        for (int i = 0; i < vars.count; i++) {
+            if ((int)strlen(vars.names[i]) == p - name && !memcmp(vars.names[i], name, p - name)) index = i;
+        }
+        if (index >= 0 && hasColumn[index]) index = -1; // 같은 이름이 또 나오면 처음 열만 사용
+        if (index >= 0) hasColumn[index] = 1;
+        fieldVariable = realloc(fieldVariable, (fieldCount + 1) * sizeof(int));
+        fieldVariable[fieldCount++] = index;
+    }
+    for (int i = 0; i < vars.count; i++) {
+        if (!hasColumn[i]) {
+            fprintf(stderr, "표에 변수 %s의 열이 없습니다: %s\n", vars.names[i], tableFile);
+            free(hasColumn);
+            free(fieldVariable);
+            free(row);
+            fclose(fp);
+            freeProgram(prog);
+            free(prog);
+            return 1;
+        }
+    }
+
+    double **columns = malloc((vars.count + 1) * sizeof(double *));
+    for (int i = 0; i < vars.count; i++) {
+        columns[i] = malloc(TABLE_BLOCK * sizeof(double));
+    }
+    double *stack = malloc((size_t)(prog->maxDepth + 1) * TABLE_BLOCK * sizeof(double));
+    double results[TABLE_BLOCK];
+    unsigned char valid[TABLE_BLOCK], rowValid[TABLE_BLOCK];
+
+    OutputBuffer out;
+    initOutputBuffer(&out);
+    printProgram(prog, &vars, &out);
+    if (opt) optimizeProgram(prog, opt);
+
+    int count = 0;
+    int done = 0;
+    while (!done) {
+        rowLength = getline(&row, &rowCapacity, fp);
+        if (rowLength < 0) {
+            done = 1;
+        } else {
+            row[strcspn(row, "\r\n")] = 0;
+            if (strspn(row, " \t,;") == strlen(row)) continue;
+            rowValid[count] = parseTableRow(row, fieldVariable, fieldCount, vars.count, columns, count);
+            if (!rowValid[count]) {
+                for (int i = 0; i < vars.count; i++) columns[i][count] = 0;
+            }
+            count++;
+        }
+
+        if (count == TABLE_BLOCK || (done && count > 0)) {
+            runProgramBlock(prog, (const double *const *)columns, count, stack, results, valid);
+            for (int r = 0; r < count; r++) {
+                if (rowValid[r] && valid[r]) {
+                    appendResult(&out, results[r]);
+                } else {
+                    appendString(&out, "Result: Invalid Expression\n");
+                }
+            }
+            count = 0;
+            if (out.length >= RANGE_BYTES) flushOutput(&out, output);
+        }
+    }
+    flushOutput(&out, output);
+
+    freeOutputBuffer(&out);
+    for (int i = 0; i < vars.count; i++) free(columns[i]);
+    free(columns);
+    free(stack);
+    free(hasColumn);
+    free(fieldVariable);
+    free(row);
+    fclose(fp);
+    freeProgram(prog);
+    free(prog);
+    return 0;
+}
+
+// 입력 파일을 한 줄씩 읽어 처리
+int processFileSequential(const char *filename, int reference, Optimizer *opt, ExactEvaluator *exact,
+                          ResultCache *cache, FILE *output) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        perror(filename);
+        return 1;
+    }
+
+    Program *prog = malloc(sizeof(Program));
+    initProgram(prog);
+    OutputBuffer out;
+    initOutputBuffer(&out);
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, fp)) > 0) {
+        processRange(line, line + length, prog, opt, exact, cache, reference, &out);
+        if (out.length >= RANGE_BYTES) flushOutput(&out, output);
+    }
+    flushOutput(&out, output);
+
+    freeOutputBuffer(&out);
+    free(line);
+    freeProgram(prog);
+    free(prog);
+    fclose(fp);
+    return 0;
+}
+
+
+// 벤치마크 (-b): 무작위 수식을 만들어 엔진마다 단계별 시간(ns/식)을 재고,
+// 컴파일 경로의 출력이 기준 구현(-r)과 같은지 확인함
+// 단계 시간은 첫 단계부터 그 단계까지를 모든 수식에 돌린 누적 시간의 차이 (BENCH_REPEAT회 중 최솟값이며
+// 짧은 단계는 측정 잡음 때문에 음수가 나올 수 있음)
+#define BENCH_REPEAT 3
+#define BENCH_MAX_LENGTH ((MAX_LINE - 1) / 9) // 기준 구현의 고정 버퍼에 들어가는 길이 (e → 9글자)
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64 (같은 시드면 같은 수식)
+static unsigned long long nextRandom(unsigned long long *state) {
+    unsigned long long x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+static int randomBelow(unsigned long long *state, int n) {
+    return (int)((nextRandom(state) >> 11) % (unsigned long long)n);
+}
+
+// 피연산자 하나 (정수, 소수, 지수 표기, e 상수, f 접미사, 괄호 안 음수)
+static void generateAtom(OutputBuffer *out, unsigned long long *state) {
+    char text[32];
+    int len;
+    switch (randomBelow(state, 8)) {
+    case 0: len = snprintf(text, sizeof(text), "%d.%d", randomBelow(state, 100), randomBelow(state, 100)); break;
+    case 1: len = snprintf(text, sizeof(text), ".%d", 1 + randomBelow(state, 99)); break;
+    case 2: len = snprintf(text, sizeof(text), "%de%d", 1 + randomBelow(state, 9), randomBelow(state, 4)); break;
+    case 3: len = snprintf(text, sizeof(text), "e"); break;
+    case 4: len = snprintf(text, sizeof(text), "%d.%df", randomBelow(state, 10), randomBelow(state, 10)); break;
+    case 5: len = snprintf(text, sizeof(text), "(-%d)", randomBelow(state, 50)); break;
+    default: len = snprintf(text, sizeof(text), "%d", randomBelow(state, 1000)); break;
+    }
+    appendText(out, text, len);
+}
+
+// 깊이 depth 이하의 수식 (operators에서 연산자를 고르므로 같은 글자를 여러 번 쓰면 그 비율이 올라감)
+static void generateExpression(OutputBuffer *out, unsigned long long *state, int depth, const char *operators,
+                               int operatorCount) {
+    if (depth == 0 || randomBelow(state, 4) == 0) {
+        generateAtom(out, state);
+        return;
+    }
+    int wrap = randomBelow(state, 8);
+    if (wrap == 0) appendString(out, "-(");
+    else if (wrap == 1) appendChar(out, '(');
+    generateExpression(out, state, depth - 1, operators, operatorCount);
+
+    char op = operators[randomBelow(state, operatorCount)];
+    int spaced = randomBelow(state, 5) != 0; // 가끔 붙여 써서 숫자가 부호를 삼키는 경우도 만듦
+    if (spaced) appendChar(out, ' ');
+    if (op == '^' && randomBelow(state, 2)) appendString(out, "**");
+    else appendChar(out, op);
+    if (spaced) appendChar(out, ' ');
+
+    generateExpression(out, state, depth - 1, operators, operatorCount);
+    if (wrap <= 1) appendChar(out, ')');
+}
+
+// 엔진마다 한 수식을 stages번째 단계까지 실행하는 함수
+typedef struct {
+    char line[MAX_LINE];
+    char tokens[MAX_TOKENS][MAX_TOKEN_LEN];
+    char postfix[MAX_TOKENS][MAX_TOKEN_LEN];
+    Program prog;
+    Optimizer opt;
+    ExactEvaluator exact;
+    double sink; // 결과를 모아 계산이 지워지지 않게 함
+} BenchContext;
+
+static void runReferenceStages(BenchContext *ctx, const char *text, size_t len, int stages) {
+    memcpy(ctx->line, text, len + 1);
+    if (isInvalidLine(ctx->line)) return;
+    preprocess_line(ctx->line);
+    if (stages < 2) return;
+    int tokenCount = tokenize(ctx->line, ctx->tokens);
+    if (stages < 3 || tokenCount < 1) return;
+    int postfixCount = toPostfix(ctx->tokens, tokenCount, ctx->postfix);
+    if (stages < 4 || postfixCount < 1) return;
+    double result;
+    if (evaluatePostfix(ctx->postfix, postfixCount, &result)) ctx->sink += result;
+}
+
+static void runBytecodeStages(BenchContext *ctx, const char *text, size_t len, int stages) {
+    if (isInvalidText(text, len) || !lexExpression(&ctx->prog.tokens, text, len, 0)) return;
+    if (stages < 2 || !compileTokens(&ctx->prog, NULL)) return;
+    double result;
+    if (stages >= 3 && runProgram(&ctx->prog, NULL, &result)) ctx->sink += result;
+}
+
+static void runOptimizedStages(BenchContext *ctx, const char *text, size_t len, int stages) {
+    if (isInvalidText(text, len) || !lexExpression(&ctx->prog.tokens, text, len, 0)) return;
+    if (stages < 2 || !compileTokens(&ctx->prog, NULL)) return;
+    if (stages < 3) return;
+    optimizeProgram(&ctx->prog, &ctx->opt);
+    double result;
+    if (stages >= 4 && runProgram(&ctx->prog, NULL, &result)) ctx->sink += result;
+}
+
+static void runExactStages(BenchContext *ctx, const char *text, size_t len, int stages) {
+    if (isInvalidText(text, len) || !lexExpression(&ctx->prog.tokens, text, len, 0)) return;
+    if (stages < 2 || !compileTokens(&ctx->prog, NULL)) return;
+    const Rational *result;
+    if (stages >= 3 && runExact(&ctx->exact, &ctx->prog, &result) == EXACT_OK) ctx->sink += result->big;
+}
+
+// 같은 수식을 확장 언어로 읽음 (연산자와 함수를 표로 찾는 비용이 기본 언어와 같은지 비교용)
+static void runExtendedStages(BenchContext *ctx, const char *text, size_t len, int stages) {
+    if (isInvalidText(text, len) || !lexExpression(&ctx->prog.tokens, text, len, LEX_EXTENDED)) return;
+    if (stages < 2 || !compileTokens(&ctx->prog, NULL)) return;
+    double result;
+    if (stages >= 3 && runProgram(&ctx->prog, NULL, &result)) ctx->sink += result;
+}
+
+// 새 엔진은 여기에 한 줄 추가
+typedef struct {
+    const char *name;
+    int stageCount;
+    const char *stages[4];
+    void (*run)(BenchContext *ctx, const char *text, size_t len, int stages);
+} BenchEngine;
+
+static const BenchEngine benchEngines[] = {
+    { "reference", 4, { "preprocess_line", "tokenize", "toPostfix", "evaluatePostfix" }, runReferenceStages },
+    { "bytecode", 3, { "lexExpression", "compileTokens", "runProgram" }, runBytecodeStages },
+    { "optimized", 4, { "lexExpression", "compileTokens", "optimizeProgram", "runProgram" }, runOptimizedStages },
+    { "exact", 3, { "lexExpression", "compileTokens", "runExact" }, runExactStages },
+    { "extended", 3, { "lexExpression", "compileTokens", "runProgram" }, runExtendedStages },
+};
+
+// 정확 계산 검사: 결과를 아는 수식 (64비트/128비트 경계와 gcd 빠른 경로 위주)
+static const struct {
+    const char *expression;
+    const char *result;
+} exactChecks[] = {
+    { "1 / 3 + 1 / 6", "Result: 1/2\n" },
+    { "2^-1", "Result: 1/2\n" },
+    { "-9223372036854775808 / -1", "Result: 9223372036854775808\n" },
+    { "2^200 / 2^199", "Result: 2\n" },
+    { "340282366920938463463374607431768211455 / 340282366920938463463374607431768211455", "Result: 1\n" },
+    { "340282366920938463463374607431768211455 / 85070591730234615865843651857942052863",
+      "Result: 113427455640312821154458202477256070485/28356863910078205288614550619314017621\n" },
+    { "510423550381407695195061911147652317184 / 850705917302346158658436518579420528640", "Result: 3/5\n" },
+};
+
+// count개 수식을 만들어 벤치마크 실행 (format: "text", "csv", "json")
+// 반환값: 기준 구현과 출력이 다른 수식이 있으면 1
+int runBenchmark(int count, int maxDepth, const char *operators, unsigned long long seed, const char *format,
+                 FILE *output) {
+    int operatorCount = (int)strlen(operators);
+    if (operatorCount == 0 || strspn(operators, "+-*/^") != (size_t)operatorCount) {
+        fprintf(stderr, "연산자는 +-*/^ 중에서 골라야 합니다: %s\n", operators);
+        return 1;
+    }
+    if (strcmp(format, "text") && strcmp(format, "csv") && strcmp(format, "json")) {
+        fprintf(stderr, "출력 형식은 text, csv, json 중 하나입니다: %s\n", format);
+        return 1;
+    }
+
+    // 수식을 NUL로 구분해 한 버퍼에 모음 (기준 구현 버퍼에 안 들어가는 길이면 다시 만듦)
+    unsigned long long state = seed ? seed : 88172645463325252ULL;
+    OutputBuffer text;
+    initOutputBuffer(&text);
+    size_t *offsets = malloc((count + 1) * sizeof(size_t));
+    for (int i = 0; i < count; i++) {
+        size_t start = text.length;
+        do {
+            text.length = start;
+            generateExpression(&text, &state, maxDepth, operators, operatorCount);
+        } while (text.length - start > BENCH_MAX_LENGTH);
+        appendChar(&text, '\0');
+        offsets[i] = start;
+    }
+    offsets[count] = text.length;
+
+    BenchContext *ctx = malloc(sizeof(BenchContext));
+    initProgram(&ctx->prog);
+    initOptimizer(&ctx->opt);
+    initExactEvaluator(&ctx->exact);
+    ctx->sink = 0;
+
+    // 단계별 시간
+    int engineCount = (int)(sizeof(benchEngines) / sizeof(benchEngines[0]));
+    double cumulative[sizeof(benchEngines) / sizeof(benchEngines[0])][4];
+    for (int e = 0; e < engineCount; e++) {
+        const BenchEngine *engine = &benchEngines[e];
+        for (int stage = 1; stage <= engine->stageCount; stage++) {
+            double best = 0;
+            for (int r = 0; r < BENCH_REPEAT; r++) {
+                double t0 = nowSeconds();
+                for (int i = 0; i < count; i++) {
+                    engine->run(ctx, text.data + offsets[i], offsets[i + 1] - offsets[i] - 1, stage);
+                }
+                double elapsed = nowSeconds() - t0;
+                if (r == 0 || elapsed < best) best = elapsed;
+            }
+            cumulative[e][stage - 1] = best * 1e9 / count;
+        }
+    }
+
+    // 차등 검사: 컴파일 경로(그대로, 최적화, 캐시)의 출력이 기준 구현과 바이트 단위로 같은지
+    OutputBuffer expected, actual;
+    initOutputBuffer(&expected);
+    initOutputBuffer(&actual);
+    ResultCache cache;
+    initResultCache(&cache, 64);
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        const char *line = text.data + offsets[i];
+        size_t len = offsets[i + 1] - offsets[i] - 1;
+        expected.length = 0;
+        memcpy(ctx->line, line, len + 1);
+        processLineReference(ctx->line, &expected);
+        for (int variant = 0; variant < 3; variant++) {
+            actual.length = 0;
+            processLine(line, len, &ctx->prog, variant == 1 ? &ctx->opt : NULL, NULL,
+                        variant == 2 ? &cache : NULL, &actual);
+            if (actual.length != expected.length || memcmp(actual.data, expected.data, actual.length)) {
+                if (mismatches < 5) {
+                    fprintf(stderr, "불일치 (%s): %s\n", variant == 0 ? "bytecode" : variant == 1 ? "optimized" : "cache",
+                            line);
+                }
+                mismatches++;
+                break;
+            }
+        }
+    }
+
+    int exactMismatches = 0;
+    for (size_t i = 0; i < sizeof(exactChecks) / sizeof(exactChecks[0]); i++) {
+        const char *line = exactChecks[i].expression;
+        const Rational *result;
+        actual.length = 0;
+        if (lexExpression(&ctx->prog.tokens, line, strlen(line), 0) && compileTokens(&ctx->prog, NULL) &&
+            runExact(&ctx->exact, &ctx->prog, &result) == EXACT_OK) {
+            appendExactResult(&actual, result, &ctx->exact);
+        }
+        if (actual.length != strlen(exactChecks[i].result) || memcmp(actual.data, exactChecks[i].result, actual.length)) {
+            fprintf(stderr, "불일치 (exact): %s\n", line);
+            exactMismatches++;
+        }
+    }
+    mismatches += exactMismatches;
+
+    double averageLength = (double)(text.length - count) / count;
+    if (!strcmp(format, "csv")) {
+        fprintf(output, "engine,stage,ns_per_expression,cumulative_ns_per_expression\n");
+    } else if (!strcmp(format, "json")) {
+        fprintf(output, "{\"expressions\": %d, \"maxDepth\": %d, \"operators\": \"%s\", \"seed\": %llu, "
+                        "\"averageLength\": %.1f, \"mismatches\": %d, \"stages\": [",
+                count, maxDepth, operators, seed, averageLength, mismatches);
+    } else {
+        fprintf(output, "[수식 벤치마크] 수식 %d개, 최대 깊이 %d, 연산자 %s, 시드 %llu, 평균 길이 %.1f바이트\n",
+                count, maxDepth, operators, seed, averageLength);
+    }
+    int first = 1;
+    for (int e = 0; e < engineCount; e++) {
+        const BenchEngine *engine = &benchEngines[e];
+        for (int s = 0; s < engine->stageCount; s++) {
+            double stageTime = cumulative[e][s] - (s > 0 ? cumulative[e][s - 1] : 0);
+            if (!strcmp(format, "csv")) {
+                fprintf(output, "%s,%s,%.1f,%.1f\n", engine->name, engine->stages[s], stageTime, cumulative[e][s]);
+            } else if (!strcmp(format, "json")) {
+                fprintf(output, "%s{\"engine\": \"%s\", \"stage\": \"%s\", \"nsPerExpression\": %.1f, "
+                                "\"cumulativeNs\": %.1f}",
+                        first ? "" : ", ", engine->name, engine->stages[s], stageTime, cumulative[e][s]);
+            } else {
+                fprintf(output, "  %-10s %-16s: %8.1f ns/식 (누적 %8.1f)\n", engine->name, engine->stages[s],
+                        stageTime, cumulative[e][s]);
+            }
+            first = 0;
+        }
+    }
+    if (!strcmp(format, "json")) {
+        fprintf(output, "]}\n");
+    } else if (!strcmp(format, "text")) {
+        fprintf(output, "  차등 검사: 수식 %d개 중 기준 구현과 다른 출력 %d개\n", count, mismatches - exactMismatches);
+        fprintf(output, "  정확 계산 검사: 수식 %d개 중 다른 결과 %d개\n",
+                (int)(sizeof(exactChecks) / sizeof(exactChecks[0])), exactMismatches);
+    } else if (mismatches) {
+        fprintf(stderr, "차등 검사: 수식 %d개 중 기준 구현과 다른 출력 %d개\n", count, mismatches);
+    }
+
+    freeResultCache(&cache);
+    freeOutputBuffer(&expected);
+    freeOutputBuffer(&actual);
+    freeOptimizer(&ctx->opt);
+    freeExactEvaluator(&ctx->exact);
+    freeProgram(&ctx->prog);
+    free(ctx);
+    free(offsets);
+    freeOutputBuffer(&text);
+    return mismatches > 0;
+}
+
+// 최적화 통계를 표준 에러에 출력
+void reportOptimizer(const Optimizer *opt) {
+    fprintf(stderr, "최적화: 명령 %lld개 → %lld개 (상수 계산 %lld회, 부호 반전 %lld회, 거듭제곱 %lld회)\n",
+            opt->before, opt->after, opt->folded, opt->negated, opt->powers);
+}
+
+// 정확 계산 통계를 표준 에러에 출력
+void reportExact(const ExactEvaluator *exact) {
+    fprintf(stderr, "정확 계산: 64비트 %lld줄, 큰 정수 %lld줄, double로 대신 계산 %lld줄\n", exact->small,
+            exact->bigLines, exact->fallback);
+}
+
+// 캐시 통계를 표준 에러에 출력
+void reportCache(const ResultCache *cache) {
+    long long lookups = cache->hits + cache->misses;
+    fprintf(stderr, "캐시: 적중 %lld회, 실패 %lld회 (적중률 %.1f%%), 교체 %lld회\n", cache->hits, cache->misses,
+            lookups ? 100.0 * cache->hits / lookups : 0.0, cache->evictions);
+}
+
+// 빌드: gcc -O2 -pthread main.c -o main -lm
+// 사용법: main [-r] [-O] [-e] [-x] [-c 캐시크기] [-j 스레드수] | main -f 수식 -t 표파일 [-O] [-x] [-k 커널]
+//         | main -b [-n 수식수] [-d 깊이] [-m 연산자] [-s 시드] [-o text|csv|json]
+//   -r: 바이트코드 대신 문자열 토큰을 거치는 기존 방식으로 계산
+//   -j: input.txt를 매핑해 여러 스레드로 나눠 계산 (0이면 CPU 코어 수, 출력 순서는 그대로)
+//   -f, -t: 변수가 들어간 수식을 한 번 컴파일해 표의 모든 행에 대해 계산 (예: -f "3*x^2 + y/2")
+//   -c: 토큰열이 같으면 이전 출력을 다시 씀 (최근에 쓴 줄 최대 N개 기억, -j면 스레드마다 N개)
+//   -O: 출력한 후위 표기식을 최적화해서 실행 (결과는 같음, 명령 수 변화는 표준 에러로 출력)
+//   -e: + - * /와 정수 지수 ^를 double 대신 기약분수로 정확히 계산해 "Result: 분자/분모"로 출력
+//       (정수가 아닌 지수처럼 분수로 나타낼 수 없는 줄은 기존처럼 double로 계산, 줄 수는 표준 에러로 출력)
+//   -x: 확장 언어로 읽음 (단항 -, 나머지 %, 오른쪽 결합 ^, sqrt sin cos tan log exp abs min max 함수,
+//       1+1처럼 숫자가 부호를 삼키지 않음, -r과 함께 쓸 수 없음)
+//   -k: 표 계산에 쓸 커널 (scalar, avx2, avx512, 기본값은 CPU가 지원하는 가장 넓은 것)
+//   -b: input.txt 대신 무작위 수식으로 단계별 벤치마크와 기준 구현 대조, 정확 계산 검사 (다른 출력이 있으면 종료 코드 1)
+//       -n 수식 수(기본 50000), -d 최대 깊이(기본 5), -m 연산자 비율(기본 "+-*/^", 예: "++*"),
+//       -s 시드, -o 결과 형식(기본 text)
+int main(int argc, char *argv[]) {
+    int reference = 0;
+    int numThreads = -1;
+    const char *formula = NULL;
+    const char *tableFile = NULL;
+    const char *kernel = NULL;
+    Optimizer *opt = NULL;
+    ExactEvaluator *exact = NULL;
+    int extended = 0;
+    int cacheSize = -1;
+    int benchmark = 0;
+    int benchCount = 50000;
+    int benchDepth = 5;
+    const char *benchOperators = "+-*/^";
+    unsigned long long benchSeed = 1;
+    const char *benchFormat = "text";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-r")) {
+            reference = 1;
+        } else if (!strcmp(argv[i], "-O")) {
+            if (!opt) opt = malloc(sizeof(Optimizer));
+            initOptimizer(opt);
+        } else if (!strcmp(argv[i], "-e")) {
+            if (!exact) exact = malloc(sizeof(ExactEvaluator));
+            initExactEvaluator(exact);
+        } else if (!strcmp(argv[i], "-x")) {
+            extended = 1;
+        } else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+            cacheSize = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            formula = argv[++i];
+        } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            tableFile = argv[++i];
+        } else if (!strcmp(argv[i], "-k") && i + 1 < argc) {
+            kernel = argv[++i];
+        } else if (!strcmp(argv[i], "-b")) {
+            benchmark = 1;
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            benchCount = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-d") && i + 1 < argc) {
+            benchDepth = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-m") && i + 1 < argc) {
+            benchOperators = argv[++i];
+        } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+            benchSeed = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            benchFormat = argv[++i];
+        } else {
+            fprintf(stderr, "사용법: %s [-r] [-O] [-e] [-x] [-c 캐시크기] [-j 스레드수] | %s -f 수식 -t 표파일 [-O] [-x] [-k 커널]\n"
+                            "        | %s -b [-n 수식수] [-d 깊이] [-m 연산자] [-s 시드] [-o text|csv|json]\n",
+                    argv[0], argv[0], argv[0]);
+            free(opt);
+            free(exact);
+            return 1;
+        }
+    }
+
+    if (benchmark) {
+        free(opt);
+        free(exact);
+        if (benchCount < 1 || benchDepth < 0) {
+            fprintf(stderr, "수식 수는 1 이상, 깊이는 0 이상이어야 합니다\n");
+            return 1;
+        }
+        return runBenchmark(benchCount, benchDepth, benchOperators, benchSeed, benchFormat, stdout);
+    }
+
+    if (extended && reference) {
+        fprintf(stderr, "-x는 -r과 함께 쓸 수 없습니다\n");
+        free(opt);
+        free(exact);
+        return 1;
+    }
+    extendedLanguage = extended;
+
+    ResultCache *cache = NULL;
+    if (cacheSize >= 0 && !reference && !formula && !tableFile) {
+        cache = malloc(sizeof(ResultCache));
+        initResultCache(cache, cacheSize);
+    }
+
+    int status = 0;
+    if (formula || tableFile) {
+        if (!formula || !tableFile) {
+            fprintf(stderr, "-f와 -t는 함께 써야 합니다\n");
+            status = 1;
+        } else if (!selectBlockKernels(kernel)) {
+            fprintf(stderr, "이 CPU에서 쓸 수 없는 커널입니다: %s\n", kernel);
+            status = 1;
+        } else {
+            status = evaluateTable(formula, tableFile, opt, stdout);
+        }
+    } else if (numThreads >= 0) {
+        status = processFileParallel("input.txt", numThreads, reference, opt, exact, cache, stdout);
+    } else {
+        status = processFileSequential("input.txt", reference, opt, exact, cache, stdout);
+    }
+
+    if (opt && status == 0) reportOptimizer(opt);
+    if (exact && status == 0 && !reference && !formula && !tableFile) reportExact(exact);
+    if (cache && status == 0) reportCache(cache);
+    if (cache) freeResultCache(cache);
+    free(cache);
+    if (exact) freeExactEvaluator(exact);
+    free(exact);
+    if (opt) freeOptimizer(opt);
+    free(opt);
+    return status;
+}
+